@@ -0,0 +1,49 @@
+#!/bin/sh
+# A large list makes many grids with pairs of nearly the same score. The grids
+# kept per round must stay bounded by NODEMAX without pairs plus PAIRFACTOR
+# times NODEMAX with pairs, a bucket of slack aside, whatever the size of the
+# list. A memory cap must hold however many grids the rounds generate.
+
+srcdir=${srcdir:-.}
+sort -u "$srcdir/worldnet.list" "$srcdir/plato.list" "$srcdir/german.list" "$srcdir/jigsaw.list" > check-frontier.list
+./jigsaw -t 0 -n 100 -J check-frontier.out check-frontier.list > /dev/null || exit 1
+awk -F'[:,]' '
+	{
+		for (i = 1; i < NF; i++) {
+			if ($i == "\"nodemax\"")
+				nodemax = $(i + 1)
+			else if ($i == "\"kept\"")
+				kept = $(i + 1)
+			else if ($i == "\"word\"")
+				word = $(i + 1)
+		}
+		if (kept > 70 * nodemax) {
+			print "round " NR ": " kept " grids kept for nodemax " nodemax
+			exit 1
+		}
+	}
+	END {
+		if (NR == 0 || word == 0)
+			exit 1
+	}' check-frontier.out || { echo "-n 100 on the merged lists failed"; exit 1; }
+
+# Under a memory cap of 1 MB nodes never take more, also with racing workers
+./jigsaw -t 0 -n 1000 -m 1 -j 2 -J check-frontier.out check-frontier.list > /dev/null || exit 1
+awk -F'[:,]' '
+	{
+		for (i = 1; i < NF; i++) {
+			if ($i == "\"mempeak\"")
+				mempeak = $(i + 1)
+			else if ($i == "\"word\"")
+				word = $(i + 1)
+		}
+		if (mempeak > 1048576) {
+			print "round " NR ": " mempeak " bytes of nodes under a cap of 1 MB"
+			exit 1
+		}
+	}
+	END {
+		if (NR == 0 || word == 0 || mempeak == "")
+			exit 1
+	}' check-frontier.out || { echo "-m 1 on the merged lists failed"; exit 1; }
+exit 0
@@ -0,0 +1,139 @@
+/*
+   jigsaw, to create crossword puzzle grids
+   Copyright 1996 https://github.com/xyzzy
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+/*
+ * Regression run of the pruning bound, on a grid small enough for the bound to
+ * matter. An incumbent one below the best word count must not cost the solve
+ * that word count, the bound may never drop a grid that leads to it. Seeded
+ * with the best word count at least a tenth of the generated grids must be
+ * dropped. With an incumbent no grid can beat every grid is dropped and the
+ * solve gets no further than its start words.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "jigsaw.h"
+
+#define SIZE	7			// Grid width and height
+
+/*
+ * Solve the list, return the # grids pruned and generated over all rounds
+ */
+
+long solve(const char *name, int *incumbent, int *numword, long *generated) {
+	struct jigsaw *js;
+	struct jigsaw_limits limits;
+	struct jigsaw_result result;
+	FILE *f, *tel;
+	char *line = NULL, *s;
+	size_t size = 0;
+	long pruned = 0;
+	int error;
+
+	f = fopen(name, "r");
+	if (f == NULL) {
+		fprintf(stderr, "fopen(%s) failed\n", name);
+		exit(1);
+	}
+	js = jigsaw_create(f, &error);
+	fclose(f);
+	if (js == NULL) {
+		fprintf(stderr, "%s: %s\n", name, jigsaw_strerror(error));
+		exit(1);
+	}
+
+	tel = tmpfile();
+	if (tel == NULL) {
+		fprintf(stderr, "tmpfile() failed\n");
+		exit(1);
+	}
+
+	jigsaw_limits_init(&limits);
+	limits.nodemax = 200;
+	limits.timemax = 0;
+	limits.width = limits.height = SIZE;
+	limits.incumbent = incumbent;
+	limits.telemetry = tel;
+	error = jigsaw_solve(js, &limits, NULL, NULL);
+	if (error != JIGSAW_OK) {
+		fprintf(stderr, "%s: %s\n", name, jigsaw_strerror(error));
+		exit(1);
+	}
+	jigsaw_result(js, &result);
+	*numword = result.numword;
+
+	// Sum the pruned and generated grids of the telemetry records
+	*generated = 0;
+	rewind(tel);
+	while (getline(&line, &size, tel) > 0) {
+		s = strstr(line, "\"pruned\":");
+		if (s)
+			pruned += atol(s + strlen("\"pruned\":"));
+		s = strstr(line, "\"generated\":");
+		if (s)
+			*generated += atol(s + strlen("\"generated\":"));
+	}
+	free(line);
+	fclose(tel);
+	jigsaw_destroy(js);
+	return pruned;
+}
+
+int main(void) {
+	const char *srcdir = getenv("srcdir");
+	char name[4096];
+	long cold, below, seeded, beyond, generated;
+	int numword, best, incumbent;
+
+	snprintf(name, sizeof(name), "%s/plato.list", srcdir ? srcdir : ".");
+
+	cold = solve(name, NULL, &best, &generated);
+	printf("word:%d pruned:%ld generated:%ld\n", best, cold, generated);
+	if (best == 0) {
+		fprintf(stderr, "no words placed\n");
+		return 1;
+	}
+
+	incumbent = best - 1;
+	below = solve(name, &incumbent, &numword, &generated);
+	printf("below-word:%d below-pruned:%ld\n", numword, below);
+	if (numword < best) {
+		fprintf(stderr, "the bound dropped a grid that leads to the best word count\n");
+		return 1;
+	}
+
+	incumbent = best;
+	seeded = solve(name, &incumbent, &numword, &generated);
+	printf("seeded-word:%d seeded-pruned:%ld seeded-generated:%ld incumbent:%d\n", numword, seeded, generated, incumbent);
+	if (10 * seeded < generated || incumbent < best) {
+		fprintf(stderr, "seeding the best word count pruned less than a tenth of the grids\n");
+		return 1;
+	}
+
+	incumbent = INT_MAX;
+	beyond = solve(name, &incumbent, &numword, &generated);
+	printf("beyond-word:%d beyond-pruned:%ld\n", numword, beyond);
+	if (beyond == 0 || numword >= best) {
+		fprintf(stderr, "an incumbent beyond reach did not prune\n");
+		return 1;
+	}
+	return 0;
+}
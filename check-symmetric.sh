@@ -0,0 +1,23 @@
+#!/bin/sh
+# Symmetrical grids of odd width or height, a word across the middle is its
+# own mirror image. Every size must place words in a point symmetric grid.
+
+srcdir=${srcdir:-.}
+for size in "15 15" "21 21" "16 15" "15 16" "16 16"; do
+	set -- $size
+	./jigsaw -t 0 -n 500 -s -W $1 -H $2 "$srcdir/plato.list" > check-symmetric.out || exit 1
+	awk -v w=$1 -v h=$2 '
+		/^[-a-z]+$/ { g[n++] = $0; if ($0 ~ /[a-z]/) chars = 1 }
+		END {
+			if (n != h || !chars)
+				exit 1
+			for (y = 0; y < h; y++) {
+				if (length(g[y]) != w)
+					exit 1
+				for (x = 1; x <= w; x++)
+					if ((substr(g[y], x, 1) == "-") != (substr(g[h - 1 - y], w + 1 - x, 1) == "-"))
+						exit 1
+			}
+		}' check-symmetric.out || { echo "-s -W $1 -H $2 failed"; cat check-symmetric.out; exit 1; }
+done
+exit 0
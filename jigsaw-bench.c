@@ -0,0 +1,357 @@
+/*
+   jigsaw, to create crossword puzzle grids
+   Copyright 1996 https://github.com/xyzzy
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+/*
+ * Benchmark the solver over word lists at fixed NODEMAX levels without a time
+ * limit. Every run is a child process so peak RSS is its own, the run using
+ * the least CPU time of the repeats is reported as a record per list and level:
+ *
+ *	list:<name> nodemax:<n> word:<n> score:<f> round:<n> node:<n> nps:<n> hashtst:<n> hashhit:<n> rss:<KB> cpu:<s> time:<s>
+ *
+ * With -s only the search counters are printed, they are the same on every
+ * machine:
+ *
+ *	list:<name> nodemax:<n> word:<n> score:<f> round:<n> node:<n> hashtst:<n> hashhit:<n>
+ *
+ * Given a baseline of those, the comparison goes to stderr and the exit code
+ * is 2 when the word count drops or the counters change. Timings only compare
+ * against a baseline made on the same machine, then CPU time or RSS growing
+ * beyond the tolerance fails too. CPU time is compared as wall time suffers
+ * from whatever else the machine is doing.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "jigsaw.h"
+
+// Configuring parameters
+
+int opt_repeat = 3;					// Runs per list and level
+int opt_threads = 1;					// # worker threads
+double opt_tolerance = 10;				// Percent CPU time and RSS may grow
+int opt_search;						// Print search counters only
+
+/*
+ * Outcome of a run, sent by the child
+ */
+struct run {
+	int		error;				// JIGSAW_OK or JIGSAW_TIMEOUT, otherwise failed
+	int		numword;			// # words placed
+	float		score;				// Score of the grid
+	int		rounds;				// # rounds
+	long		nodes;				// # grids scanned
+	long		hashtst, hashhit;		// Duplicate compares, false positives
+	double		elapsed;			// Seconds solving
+	long		rss;				// Peak RSS in KB
+	double		cpu;				// CPU seconds incl. loading
+	double		wall;				// Seconds incl. loading
+};
+
+/*
+ * Records of a baseline report
+ */
+struct baseline {
+	char		**rec;
+	int		num, max;			// How many
+} search, timing;
+
+void usage(char ** argv)
+{
+        fprintf(stderr,"usage: %s [options] <wordlist> ...\n", argv[0]);
+	fprintf(stderr,"\t-h\thelp\n");
+	fprintf(stderr,"\t-n N,..\tNODEMAX levels (default 1000,10000)\n");
+	fprintf(stderr,"\t-r N\truns per level, least CPU time counts (default %d)\n", opt_repeat);
+	fprintf(stderr,"\t-j N\tworker threads (default %d)\n", opt_threads);
+	fprintf(stderr,"\t-s\tsearch counters only\n");
+	fprintf(stderr,"\t-c file\tcompare search counters against baseline report\n");
+	fprintf(stderr,"\t-t file\tcompare CPU time and RSS against baseline report of this machine\n");
+	fprintf(stderr,"\t-T N\tpercent CPU time and RSS may grow (default %g)\n", opt_tolerance);
+        exit(1);
+}
+
+/*
+ * Solve in a child process, peak RSS is that of the child
+ */
+
+void run_list(const char *name, int nodemax, struct run *r) {
+	struct jigsaw_limits limits;
+	struct jigsaw_result result;
+	struct jigsaw *js;
+	struct timespec start, stop;
+	struct rusage usage;
+	int fd[2], status;
+	pid_t pid;
+	FILE *f;
+
+	memset(r, 0, sizeof(*r));
+	if (pipe(fd)) {
+		fprintf(stderr, "Cannot create pipe\n");
+		exit(1);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pid = fork();
+	if (pid < 0) {
+		fprintf(stderr, "Cannot fork\n");
+		exit(1);
+	}
+
+	if (pid == 0) {
+		close(fd[0]);
+		f = fopen(name, "r");
+		if (f == NULL) {
+			fprintf(stderr, "Cannot open %s\n", name);
+			_exit(1);
+		}
+		js = jigsaw_create(f, &r->error);
+		fclose(f);
+		if (js) {
+			jigsaw_limits_init(&limits);
+			limits.timemax = 0;
+			limits.nodemax = nodemax;
+			limits.threads = opt_threads;
+			r->error = jigsaw_solve(js, &limits, NULL, NULL);
+			jigsaw_result(js, &result);
+			r->numword = result.numword;
+			r->score = result.score;
+			r->rounds = result.rounds;
+			r->nodes = result.nodes;
+			r->hashtst = result.hashtst;
+			r->hashhit = result.hashhit;
+			r->elapsed = result.elapsed;
+		}
+		if (write(fd[1], r, sizeof(*r)) != sizeof(*r))
+			_exit(1);
+		_exit(0);
+	}
+
+	close(fd[1]);
+	if (read(fd[0], r, sizeof(*r)) != sizeof(*r) || wait4(pid, &status, 0, &usage) != pid ||
+	    !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		fprintf(stderr, "Run of %s failed\n", name);
+		exit(1);
+	}
+	close(fd[0]);
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+	r->rss = usage.ru_maxrss;
+	r->cpu = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+	r->wall = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/*
+ * Load a baseline report
+ */
+
+void load_baseline(struct baseline *b, const char *name) {
+	char line[1024];
+	FILE *f;
+
+	f = fopen(name, "r");
+	if (f == NULL) {
+		fprintf(stderr, "Cannot open %s\n", name);
+		exit(1);
+	}
+	while (fgets(line, sizeof(line), f)) {
+		if (strncmp(line, "list:", 5) != 0)
+			continue;
+		if (b->num == b->max) {
+			b->max = b->max ? 2 * b->max : 64;
+			b->rec = (char **) realloc(b->rec, b->max * sizeof(char *));
+			if (b->rec == NULL) {
+				fprintf(stderr, "Out of memory\n");
+				exit(1);
+			}
+		}
+		b->rec[b->num] = strdup(line);
+		if (b->rec[b->num++] == NULL) {
+			fprintf(stderr, "Out of memory\n");
+			exit(1);
+		}
+	}
+	fclose(f);
+}
+
+/*
+ * Value of a field in a record, -1 if it has none
+ */
+
+double field(const char *line, const char *key) {
+	const char *p;
+	size_t len = strlen(key);
+
+	for (p = line; (p = strstr(p, key)); p += len) {
+		if ((p == line || p[-1] == ' ') && p[len] == ':')
+			return strtod(p + len + 1, NULL);
+	}
+	return -1;
+}
+
+/*
+ * Record of a list and level in a baseline, NULL if it has none
+ */
+
+const char *find_record(struct baseline *b, const char *list, int nodemax) {
+	char key[512];
+	int i;
+
+	snprintf(key, sizeof(key), "list:%s nodemax:%d ", list, nodemax);
+	for (i = 0; i < b->num; i++)
+		if (strncmp(b->rec[i], key, strlen(key)) == 0)
+			return b->rec[i];
+	return NULL;
+}
+
+/*
+ * Compare a run against its baseline records. Returns 1 on a regression.
+ */
+
+int compare(const char *list, int nodemax, struct run *r) {
+	const char *rec;
+	double rss, cpu;
+	int ret = 0;
+
+	fprintf(stderr, "%s nodemax:%d", list, nodemax);
+
+	// Counters only change with the search itself
+	rec = find_record(&search, list, nodemax);
+	if (rec) {
+		fprintf(stderr, " word:%d/%.0f node:%ld/%.0f", r->numword, field(rec, "word"), r->nodes, field(rec, "node"));
+		if (r->numword < field(rec, "word")) {
+			fprintf(stderr, " REGRESSION-word");
+			ret = 1;
+		}
+		if (r->nodes != (long) field(rec, "node") || r->rounds != (int) field(rec, "round") ||
+		    r->hashtst != (long) field(rec, "hashtst") || r->hashhit != (long) field(rec, "hashhit")) {
+			fprintf(stderr, " CHANGED-search");
+			ret = 1;
+		}
+	} else if (search.num) {
+		fprintf(stderr, " not in baseline");
+	}
+
+	// Timings, of this machine
+	rec = find_record(&timing, list, nodemax);
+	if (rec) {
+		rss = field(rec, "rss");
+		cpu = field(rec, "cpu");
+		fprintf(stderr, " cpu:%.3f/%.3f %+.1f%% rss:%ld/%.0f %+.1f%%",
+			r->cpu, cpu, 100 * (r->cpu / cpu - 1), r->rss, rss, 100 * (r->rss / rss - 1));
+		if (r->cpu > cpu * (1 + opt_tolerance / 100)) {
+			fprintf(stderr, " REGRESSION-cpu");
+			ret = 1;
+		}
+		if (r->rss > rss * (1 + opt_tolerance / 100)) {
+			fprintf(stderr, " REGRESSION-rss");
+			ret = 1;
+		}
+	} else if (timing.num) {
+		fprintf(stderr, " not in timing baseline");
+	}
+	fprintf(stderr, "\n");
+	return ret;
+}
+
+int main(int argc, char **argv) {
+	struct run r, best;
+	char *levels = "1000,10000", *p, *list;
+	int opt, i, n, nodemax, regressions = 0;
+
+	while ((opt = getopt(argc, argv, "hn:r:j:sc:t:T:")) != -1) {
+		switch (opt) {
+		case 'n':
+			levels = optarg;
+			break;
+		case 'r':
+			opt_repeat = atoi(optarg);
+			if (opt_repeat < 1) {
+				fprintf(stderr, "Runs must be positive\n");
+				exit(1);
+			}
+			break;
+		case 'j':
+			opt_threads = atoi(optarg);
+			if (opt_threads < 1 || opt_threads > JIGSAW_THREADMAX) {
+				fprintf(stderr, "Threads must be 1..%d\n", JIGSAW_THREADMAX);
+				exit(1);
+			}
+			break;
+		case 's':
+			opt_search = 1;
+			break;
+		case 'c':
+			load_baseline(&search, optarg);
+			break;
+		case 't':
+			load_baseline(&timing, optarg);
+			break;
+		case 'T':
+			opt_tolerance = atof(optarg);
+			break;
+		default: /* 'h' '?' */
+			usage(argv);
+		}
+	}
+	if (optind >= argc)
+		usage(argv);
+
+	for (i = optind; i < argc; i++) {
+		// Lists are known by their name, wherever the build tree is
+		list = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+
+		for (p = levels; *p; p += strspn(p, ",")) {
+			nodemax = atoi(p);
+			p += strcspn(p, ",");
+			if (nodemax < 1) {
+				fprintf(stderr, "NODEMAX levels must be positive\n");
+				exit(1);
+			}
+
+			for (n = 0; n < opt_repeat; n++) {
+				run_list(argv[i], nodemax, &r);
+				if (n == 0 || r.cpu < best.cpu)
+					best = r;
+			}
+
+			if (best.error != JIGSAW_OK && best.error != JIGSAW_TIMEOUT) {
+				printf("list:%s nodemax:%d error:%s\n", list, nodemax, jigsaw_strerror(best.error));
+				fflush(stdout);
+				continue;
+			}
+			if (opt_search)
+				printf("list:%s nodemax:%d word:%d score:%f round:%d node:%ld hashtst:%ld hashhit:%ld\n",
+				       list, nodemax, best.numword, best.score, best.rounds, best.nodes, best.hashtst, best.hashhit);
+			else
+				printf("list:%s nodemax:%d word:%d score:%f round:%d node:%ld nps:%.0f hashtst:%ld hashhit:%ld rss:%ld cpu:%.3f time:%.3f\n",
+				       list, nodemax, best.numword, best.score, best.rounds, best.nodes,
+				       best.elapsed > 0 ? best.nodes / best.elapsed : 0.0, best.hashtst, best.hashhit, best.rss, best.cpu, best.wall);
+			fflush(stdout);
+
+			if (search.num || timing.num)
+				regressions += compare(list, nodemax, &best);
+		}
+	}
+
+	exit(regressions ? 2 : 0);
+}
@@ -0,0 +1,127 @@
+/*
+   jigsaw-client, send a word list to a jigsaw -S service
+   Copyright 1996 https://github.com/xyzzy
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+void usage(char ** argv)
+{
+        fprintf(stderr,"usage: %s [options] <socket> [<wordlist>]\n", argv[0]);
+	fprintf(stderr,"\t-h\thelp\n");
+	fprintf(stderr,"\t-s\tsymmetrical\n");
+	fprintf(stderr,"\t-t N\tTIMEMAX in seconds, or with ms milliseconds\n");
+	fprintf(stderr,"\t-C\tTIMEMAX is CPU time\n");
+	fprintf(stderr,"\t-I\tspend the time left improving the solution\n");
+	fprintf(stderr,"\t-n N\tNODEMAX, or auto\n");
+	fprintf(stderr,"\t-e list\tscore evaluators name:weight,..\n");
+	fprintf(stderr,"\t-m N\tmemory cap in MB\n");
+	fprintf(stderr,"\t-W N\tgrid width\n");
+	fprintf(stderr,"\t-H N\tgrid height\n");
+	fprintf(stderr,"Options not given use the defaults of the service\n");
+        exit(1);
+}
+
+int main(int argc, char **argv) {
+	struct sockaddr_un addr;
+	char request[1024], line[4096];
+	FILE *f, *sock;
+	int opt, fd, len;
+
+	// Options are passed on as they are, the service checks them
+	request[0] = 0;
+	while ((opt = getopt(argc, argv, "hsCIt:n:e:m:W:H:")) != -1) {
+		switch (opt) {
+		case 's':
+			strcat(request, " -s");
+			break;
+		case 'C':
+			strcat(request, " -C");
+			break;
+		case 'I':
+			strcat(request, " -I");
+			break;
+		case 't':
+		case 'e':
+		case 'n':
+		case 'm':
+		case 'W':
+		case 'H':
+			if (strlen(request) + strlen(optarg) + 5 >= sizeof(request) || strpbrk(optarg, " \t\r\n"))
+				usage(argv);
+			sprintf(request + strlen(request), " -%c %s", opt, optarg);
+			break;
+		default: /* 'h' '?' */
+			usage(argv);
+		}
+	}
+	if (optind >= argc)
+		usage(argv);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(argv[optind]) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Socket name too long\n");
+		exit(1);
+	}
+	strcpy(addr.sun_path, argv[optind++]);
+
+	if (optind < argc) {
+		f = fopen(argv[optind], "r");
+		if (!f) {
+			fprintf(stderr, "Cannot open %s\n", argv[optind]);
+			exit(1);
+		}
+	} else {
+		f = stdin;
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr *) &addr, sizeof(addr))) {
+		fprintf(stderr, "Cannot connect to %s\n", addr.sun_path);
+		exit(1);
+	}
+	sock = fdopen(fd, "r+");
+	if (sock == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+
+	// Send the request, empty lines would end the word list
+	fprintf(sock, "%s\n", request);
+	while (fgets(line, sizeof(line), f)) {
+		len = strspn(line, " \t\r\n");
+		if (line[len] != 0)
+			fputs(line, sock);
+	}
+	fprintf(sock, "\n");
+	fflush(sock);
+	shutdown(fd, SHUT_WR);
+	fclose(f);
+
+	// Copy the response
+	while (fgets(line, sizeof(line), sock))
+		fputs(line, stdout);
+	fclose(sock);
+
+	exit(0);
+}
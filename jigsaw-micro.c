@@ -0,0 +1,441 @@
+/*
+   jigsaw, to create crossword puzzle grids
+   Copyright 1996 https://github.com/xyzzy
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+/*
+ * Micro benchmark of the solver kernels. A solve runs until its solution has
+ * the requested number of words, the grids its round is scanning at that
+ * moment are captured and the kernels are replayed on them in a tight loop:
+ *
+ *	kernel:<name> op:<n> ns:<f> cycles:<f>
+ *
+ * A pass replays a kernel on all captured grids, or on all candidate words
+ * scan_grid() would try on them. Passes repeat for the given time, the fastest
+ * pass is reported per operation. Cycles are time stamp counter ticks.
+ * scan_grid needs a freshly expanded grid, its figure has expand_node
+ * subtracted. add_node inserts the children scan_grid made into scores[]
+ * populated with the captured grids.
+ *
+ * The kernels are static, the library is included whole.
+ */
+
+#include "libjigsaw.c"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TICKS()		__rdtsc()
+#else
+#define TICKS()		0
+#endif
+
+// Configuring parameters
+
+int opt_words = 30;					// Capture when the solution has this many words
+int opt_capture = 200;					// # grids to capture
+double opt_time = 1;					// Seconds per kernel
+
+/*
+ * A word scan_grid() would try on a grid
+ */
+struct cand {
+	struct node	*full;				// Expanded grid
+	int		xy;				// Where the word starts
+	int		word;				// What's the word
+};
+
+struct jigsaw *js;
+struct node **captured;					// Stored grids, a reference each
+struct node **fulls;					// Same grids expanded
+int numcaptured;					// How many
+int capturedwords;					// # words of the solution at the capture
+struct cand *hcand, *vcand;				// Candidate words by direction
+int numhcand, numvcand, maxhcand, maxvcand;		// How many
+struct node *scratch;					// Grid being scanned
+struct job job;						// Collects generated grids
+volatile long sink;					// Keeps results alive
+
+void usage(char ** argv)
+{
+        fprintf(stderr,"usage: %s [options] <wordlist>\n", argv[0]);
+	fprintf(stderr,"\t-h\thelp\n");
+	fprintf(stderr,"\t-n N\tNODEMAX of the capturing run (default 1000)\n");
+	fprintf(stderr,"\t-w N\tcapture when the solution has N words (default %d)\n", opt_words);
+	fprintf(stderr,"\t-c N\tgrids to capture (default %d)\n", opt_capture);
+	fprintf(stderr,"\t-t N\tseconds per kernel (default %g)\n", opt_time);
+	fprintf(stderr,"\t-W N\tgrid width (default 20)\n");
+	fprintf(stderr,"\t-H N\tgrid height (default 20)\n");
+	fprintf(stderr,"\t-s\tsymmetrical\n");
+        exit(1);
+}
+
+/*
+ * Keep the grids of the round once the solution is large enough. The grid
+ * being scanned is followed by those the round has left in the order they are
+ * scanned, best first.
+ */
+
+int capture(struct jigsaw *js, void *arg) {
+	struct node *d;
+
+	(void) arg;
+	if (js->solution->numword < opt_words)
+		return 0;
+	capturedwords = js->solution->numword;
+	for (d = js->workers[0].scratch->parent; d && numcaptured < opt_capture; d = d->next) {
+		d->refcnt++;
+		captured[numcaptured++] = d;
+	}
+	return 1;
+}
+
+/*
+ * Collect the candidate words at a cell the way scan_grid() finds them
+ */
+
+void add_cand(struct cand **cand, int *num, int *max, struct node *full, int xy, int word) {
+	if (*num == *max) {
+		*max = *max ? 2 * *max : 4096;
+		*cand = (struct cand *) realloc(*cand, *max * sizeof(struct cand));
+		if (*cand == NULL) {
+			fprintf(stderr, "Out of memory\n");
+			exit(1);
+		}
+	}
+	(*cand)[*num].full = full;
+	(*cand)[*num].xy = xy;
+	(*cand)[(*num)++].word = word;
+}
+
+void find_cands(struct node *d) {
+	uint32_t before, after;
+	struct link *ld;
+	int xy, l, tstxy;
+
+	for (xy = 0; xy < js->gridsize; xy++) {
+		if (ATTR(d)[xy] & TODOH) {
+			before = cell_mask(js, d, xy - 1, js->gridxmax);
+			after = cell_mask(js, d, xy + 1, js->gridxmax);
+			for (l = js->links1[d->grid[xy]]; l; l = ld->next) {
+				ld = &js->linkdat[l];
+				if (INSET(WORDS(d), ld->w) || !(before >> ld->prev & after >> ld->post & 1))
+					continue;
+				tstxy = xy + ld->ofs;
+				if (tstxy >= 0)
+					add_cand(&hcand, &numhcand, &maxhcand, d, tstxy, ld->w);
+			}
+		}
+		if (ATTR(d)[xy] & TODOV) {
+			before = cell_mask(js, d, xy - js->gridxmax, 1);
+			after = cell_mask(js, d, xy + js->gridxmax, 1);
+			for (l = js->links1[d->grid[xy]]; l; l = ld->next) {
+				ld = &js->linkdat[l];
+				if (INSET(WORDS(d), ld->w) || !(before >> ld->prev & after >> ld->post & 1))
+					continue;
+				tstxy = xy + ld->ofs * js->gridxmax;
+				if (tstxy >= 0)
+					add_cand(&vcand, &numvcand, &maxvcand, d, tstxy, ld->w);
+			}
+		}
+	}
+}
+
+/*
+ * Empty scores[] and the duplicate table, like the start of a round
+ */
+
+void reset_scores(void) {
+	struct node *d, *next;
+	int i;
+
+	for (i = 0; i < SCOREMAX; i++) {
+		for (d = js->scores[i]; d; d = next) {
+			next = d->next;
+			release_node(js, d);
+		}
+		js->scores[i] = NULL;
+		js->scoretail[i] = &js->scores[i];
+	}
+	memset(js->hashtab, 0, js->hashsize * sizeof(struct hashent));
+	js->hashused = 0;
+	memset(js->bucketcnt, 0, sizeof(js->bucketcnt));
+	memset(js->cutbucket, 0, sizeof(js->cutbucket));
+	memset(js->numfrontier, 0, sizeof(js->numfrontier));
+	js->frontiermem = 0;
+	js->numnode = js->realnumnode = 0;
+}
+
+/*
+ * Release the grids collected by the job
+ */
+
+void release_job(void) {
+	struct node *d, *next;
+
+	for (d = job.child; d; d = next) {
+		next = d->next;
+		release_node(js, d);
+	}
+	job.child = NULL;
+	job.childtail = &job.child;
+}
+
+/*
+ * The kernels, a pass returns the # operations
+ */
+
+long run_expand(void) {
+	int i;
+
+	for (i = 0; i < numcaptured; i++)
+		expand_node(js, captured[i], scratch);
+	return numcaptured;
+}
+
+long run_test_hword(void) {
+	long cnt = 0;
+	int i;
+
+	for (i = 0; i < numhcand; i++)
+		cnt += test_hword(js, hcand[i].full, hcand[i].xy, hcand[i].word);
+	sink = cnt;
+	return numhcand;
+}
+
+long run_test_vword(void) {
+	long cnt = 0;
+	int i;
+
+	for (i = 0; i < numvcand; i++)
+		cnt += test_vword(js, vcand[i].full, vcand[i].xy, vcand[i].word);
+	sink = cnt;
+	return numvcand;
+}
+
+long run_place_hword(void) {
+	int i;
+
+	curjob = &job;
+	for (i = 0; i < numhcand; i++)
+		place_hword(js, hcand[i].full, hcand[i].xy, hcand[i].word);
+	curjob = NULL;
+	return numhcand;
+}
+
+long run_place_vword(void) {
+	int i;
+
+	curjob = &job;
+	for (i = 0; i < numvcand; i++)
+		place_vword(js, vcand[i].full, vcand[i].xy, vcand[i].word);
+	curjob = NULL;
+	return numvcand;
+}
+
+long run_scan_grid(void) {
+	int i;
+
+	curjob = &job;
+	for (i = 0; i < numcaptured; i++) {
+		expand_node(js, captured[i], scratch);
+		scan_grid(js, scratch);
+	}
+	curjob = NULL;
+	return numcaptured;
+}
+
+// scores[] holds the captured grids, the job the children to add
+void setup_add_node(void) {
+	int i;
+
+	reset_scores();
+	for (i = 0; i < numcaptured; i++) {
+		captured[i]->refcnt++;
+		add_node(js, captured[i]);
+	}
+	run_scan_grid();
+}
+
+long run_add_node(void) {
+	struct node *d, *next;
+	long cnt = 0;
+
+	for (d = job.child; d; d = next, cnt++) {
+		next = d->next;
+		add_node(js, d);
+	}
+	job.child = NULL;
+	job.childtail = &job.child;
+	return cnt;
+}
+
+/*
+ * Repeat passes for the given time, returns ns/op of the fastest
+ */
+
+double run_kernel(const char *name, void (*setup)(void), long (*run)(void), void (*cleanup)(void), double subtract) {
+	struct timespec start, t0, t1;
+	uint64_t c0, c1;
+	double ns, best = 0, bestcycles = 0;
+	long ops, bestops = 0;
+	int pass;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (pass = 0; ; pass++) {
+		if (setup)
+			setup();
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		c0 = TICKS();
+		ops = run();
+		c1 = TICKS();
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		if (cleanup)
+			cleanup();
+
+		ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+		if (ops > 0 && (pass == 0 || ns / ops < best)) {
+			best = ns / ops;
+			bestcycles = (double) (c1 - c0) / ops;
+			bestops = ops;
+		}
+		if (pass >= 2 && (t1.tv_sec - start.tv_sec) + (t1.tv_nsec - start.tv_nsec) / 1e9 >= opt_time)
+			break;
+	}
+
+	// Less what had to be replayed with it
+	printf("kernel:%s op:%ld ns:%.1f cycles:%.1f\n", name, bestops, best - subtract,
+	       best > 0 ? bestcycles * (1 - subtract / best) : 0.0);
+	fflush(stdout);
+	return best;
+}
+
+int main(int argc, char **argv) {
+	struct jigsaw_limits limits;
+	double expand;
+	char *list;
+	int opt, i, error;
+	FILE *f;
+
+	jigsaw_limits_init(&limits);
+	limits.nodemax = 1000;
+	limits.timemax = 0;
+
+	while ((opt = getopt(argc, argv, "hn:w:c:t:W:H:s")) != -1) {
+		switch (opt) {
+		case 'n':
+			limits.nodemax = atoi(optarg);
+			break;
+		case 'w':
+			opt_words = atoi(optarg);
+			break;
+		case 'c':
+			opt_capture = atoi(optarg);
+			if (opt_capture < 1) {
+				fprintf(stderr, "Capture must be positive\n");
+				exit(1);
+			}
+			break;
+		case 't':
+			opt_time = atof(optarg);
+			break;
+		case 'W':
+			limits.width = atoi(optarg);
+			break;
+		case 'H':
+			limits.height = atoi(optarg);
+			break;
+		case 's':
+			limits.symmetrical = 1;
+			break;
+		default: /* 'h' '?' */
+			usage(argv);
+		}
+	}
+	if (optind != argc - 1)
+		usage(argv);
+
+	f = fopen(argv[optind], "r");
+	if (f == NULL) {
+		fprintf(stderr, "Cannot open %s\n", argv[optind]);
+		exit(1);
+	}
+	js = jigsaw_create(f, &error);
+	fclose(f);
+	if (js == NULL) {
+		fprintf(stderr, "%s\n", jigsaw_strerror(error));
+		exit(1);
+	}
+
+	// Run until the solution is large enough, the geometry stays for the kernels
+	captured = (struct node **) malloc(opt_capture * sizeof(struct node *));
+	if (captured == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	error = jigsaw_solve(js, &limits, capture, NULL);
+	if (error != JIGSAW_STOPPED || numcaptured == 0) {
+		fprintf(stderr, "Solve ended before %d words, lower -w\n", opt_words);
+		exit(1);
+	}
+
+	// Replays must not nominate or prune
+	js->callback = NULL;
+	js->solution->numword = js->numword;
+	js->incumbent = 0;
+	reset_scores();
+	job.childtail = &job.child;
+
+	scratch = (struct node *) malloc(js->scratchsize);
+	fulls = (struct node **) malloc(numcaptured * sizeof(struct node *));
+	if (scratch == NULL || fulls == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	for (i = 0; i < numcaptured; i++) {
+		fulls[i] = (struct node *) malloc(js->scratchsize);
+		if (fulls[i] == NULL) {
+			fprintf(stderr, "Out of memory\n");
+			exit(1);
+		}
+		expand_node(js, captured[i], fulls[i]);
+		find_cands(fulls[i]);
+	}
+
+	list = strrchr(argv[optind], '/') ? strrchr(argv[optind], '/') + 1 : argv[optind];
+	printf("list:%s nodemax:%d word:%d grid:%d hword:%d vword:%d\n",
+	       list, limits.nodemax, capturedwords, numcaptured, numhcand, numvcand);
+
+	expand = run_kernel("expand_node", NULL, run_expand, NULL, 0);
+	run_kernel("test_hword", NULL, run_test_hword, NULL, 0);
+	run_kernel("test_vword", NULL, run_test_vword, NULL, 0);
+	run_kernel("place_hword", NULL, run_place_hword, release_job, 0);
+	run_kernel("place_vword", NULL, run_place_vword, release_job, 0);
+	run_kernel("scan_grid", NULL, run_scan_grid, release_job, expand);
+	run_kernel("add_node", setup_add_node, run_add_node, NULL, 0);
+
+	reset_scores();
+	for (i = 0; i < numcaptured; i++) {
+		release_node(js, captured[i]);
+		free(fulls[i]);
+	}
+	free(fulls);
+	free(captured);
+	free(scratch);
+	free(hcand);
+	free(vcand);
+	jigsaw_destroy(js);
+	return 0;
+}
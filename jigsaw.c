@@ -20,1015 +20,936 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
-#include <unistd.h>
 #include <stdint.h>
-#include <sys/times.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
 #include <signal.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "jigsaw.h"
 
 // Configuring parameters
 
-int opt_debug;						// 0=Off 1=On 2=Verbose
-int opt_symmetrical;					// 0=No 1=Yes
-int opt_dump;						// 0=No 1=after every round 2=after every addNode
-int opt_timemax = (10*60-15);				// 10 minute limit
-int opt_nodemax = 15000;				// 500=Fast 1500=Normal
-
-#define GRIDXMAX	(20+2)				// Size of grid incl. border
-#define GRIDYMAX	(20+2)				// Size of grid incl. border
-#define LINKMAX		4096				// # links
-#define WORDMAX		256				// # words
-#define WORDLENMAX	32				// # length of word
-#define ADJMAX		128				// # unaccounted adjacent chars
-#define SCOREMAX	1000				// Spead for hashing
-
-#define BASE		('a'-1)				// Word conversion
-#define STAR		(28)				// Word delimiters
-#define FREE		(31)				// Unoccupied grid cell
-#define TODOH		1				// Hint: Hor. word can be here
-#define TODOV		2				// Hint: Ver. word can be here
-#define BORDER		4				// Cell is grid border
-
-#define ISSTAR(C)	((C)==STAR)			// Test the above
-#define ISFREE(C)	((C)==FREE)
-#define ISCHAR(C)	((C)< STAR)
-#define ISBORDER(C)	((C)&BORDER)
-
-#define BITSET(M, B) ((M).s[(B)>>3] |=  (1<<((B)&7)))	// BitSet manipulation
-#define BITCLR(M, B) ((M).s[(B)>>3] &= ~(1<<((B)&7)))
-#define INSET(M, B)  ((M).s[(B)>>3] &   (1<<((B)&7)))
-
-typedef struct {					// Bitset containing 256 bits
-	uint8_t s[32];
-} SET;
-
-struct node {
-	struct node	*next;				//
-	int		seqnr;				// For diagnostics
-	SET		words;				// Summary of placed words
-	int		numword, numchar, numconn;	// Statistics
-	uint32_t	hash;				// Duplicate detection
-	int		firstlevel, lastlevel;		// Grids hotspot
-	float		score;				// Will it survive?
-	int8_t		symdir;				// Force symmetry
-	int16_t		symxy;				//
-	int16_t		symlen;				//
-	int		numadj;				// # unprocessed char pairs
-	int8_t		adjdir[ADJMAX];			// Pair's direction
-	int16_t		adjxy[ADJMAX];			// Pair's location
-	int16_t		adjl[ADJMAX];			// Pair's wordlist
-	uint8_t		grid[GRIDXMAX * GRIDYMAX];	// *THE* grid
-	uint8_t		attr[GRIDXMAX * GRIDYMAX];	// Grid hints
-};
+struct jigsaw_limits limits;				// Per solve
+int opt_stream;						// 0=No 1=Print every improved solution
+int opt_batch;						// # concurrent solves, 0=Single word list
+int opt_manifest;					// 0=Lists separated by empty lines 1=File names
+char *opt_socket;					// Serve requests on this socket
+int opt_portfolio;					// # configurations to race, 0=None
+char *opt_resume;					// Continue from this checkpoint
+char *opt_telemetry;					// JSON record per round to this file
+volatile int terminated;				// SIGTERM received
 
-struct link {
-	int16_t next;
-	int16_t w;					// What's the word
-	int16_t ofs;					// Were's in the word
+/*
+ * Batch administration. Results are collected per list and printed in input
+ * order.
+ */
+struct puzzle {
+	char	*text;					// Output record
+	int	done;					// Text is complete
 };
 
+FILE *batchin;						// Lists or manifest
+struct puzzle *puzzles;					// Lists read so far
+int numpuzzle, maxpuzzle;				// How many
+int batcheof;						// Input exhausted
+pthread_mutex_t batchmutex = PTHREAD_MUTEX_INITIALIZER;	// Guards the above
+pthread_cond_t batchcond = PTHREAD_COND_INITIALIZER;	// Puzzle completed
 
-// The external word list
-uint8_t wordbase[WORDMAX][WORDLENMAX];			// Converted wordlist
-int wlen[WORDMAX];					// Length of words
-int numword;						// How many
+/*
+ * Portfolio configurations, applied to the limits of the command line. The
+ * first is the command line as is.
+ */
+struct member {
+	float		nodemax;			// NODEMAX factor
+	int		start;				// Start words 0=Top-left 1=Centre
+	int		startmin;			// Min. length of start words
+	float		weight;				// Score of a word in connections
+	struct jigsaw	*js;				// Its solver
+	struct jigsaw_limits limits;
+	int		error;
+	pthread_t	tid;
+} portfolio[] = {
+	{ 1.0, 0, 0, 0.0, NULL, { 0 }, 0, 0 },
+	{ 0.5, 0, 0, 0.0, NULL, { 0 }, 0, 0 },
+	{ 2.0, 0, 0, 0.0, NULL, { 0 }, 0, 0 },
+	{ 1.0, 1, 0, 0.0, NULL, { 0 }, 0, 0 },
+	{ 1.0, 0, 4, 0.0, NULL, { 0 }, 0, 0 },
+	{ 1.0, 0, 0, 0.5, NULL, { 0 }, 0, 0 },
+	{ 0.5, 1, 4, 0.5, NULL, { 0 }, 0, 0 },
+	{ 2.0, 0, 0, 1.0, NULL, { 0 }, 0, 0 },
+};
 
-// Where are 1,2,3 long character combinations
-int16_t links1[32];					// 1-char wordlist
-int16_t links2[32][32];					// 2-char wordlist
-int16_t links3[32][32][32];				// 3-char wordlist
-struct link linkdat[LINKMAX];				// Body above wordlist
-int numlinkdat;						// How many
+#define PORTFOLIOMAX	((int) (sizeof(portfolio) / sizeof(portfolio[0])))
 
-// Hotspot pre-calculations
-int16_t xy2level[GRIDXMAX * GRIDYMAX];			// distance 0,0 to x,y
-int16_t level2xy[GRIDXMAX + GRIDYMAX + 1];		// inverse
+char *listtext;						// Word list of the members
+size_t listsize;
+int incumbent;						// Best # words of all members
 
-// Node administration
-struct node *freenode;					// Don't malloc() too much
-int numnode, realnumnode;				// Statistics
-struct node solution;					// What are we doing?
-struct node *scores[SCOREMAX];				// Speed up hashing
+/*
+ * Service administration. Contexts are cached by the hash of their word
+ * list, a request for a known list skips loading. Otherwise the least
+ * recently used idle context loads the list, keeping its node memory.
+ */
+#define CACHEMIN	8				// Min. # cached contexts
 
-// Diagnostics
-int seqnr;
-int hashtst, hashhit;
-int nummalloc;
-int numscan;
+struct cached {
+	struct jigsaw	*js;				// NULL if unused
+	uint64_t	hash;				// Of word list, 0 if none
+	int		busy;				// Checked out by a request
+	long		lastuse;			// For LRU
+};
 
-// What's left
-int ticks;
+int listenfd;						// Socket to accept() on
+struct cached *cache;					// Contexts
+int numcache;						// How many
+long cacheclock;					// LRU clock
+pthread_mutex_t cachemutex = PTHREAD_MUTEX_INITIALIZER;	// Guards the above
+
+void usage(char ** argv)
+{
+        fprintf(stderr,"usage: %s [<wordlist>]\n", argv[0]);
+	fprintf(stderr,"\t-h\thelp\n");
+	fprintf(stderr,"\t-s\tsymmetrical\n");
+	fprintf(stderr,"\t-i\tprint every improved solution\n");
+	fprintf(stderr,"\t-t N\tTIMEMAX in seconds, or with ms milliseconds (default %d)\n", limits.timemax);
+	fprintf(stderr,"\t-C\tTIMEMAX is CPU time\n");
+	fprintf(stderr,"\t-I\tspend the time left improving the solution\n");
+	fprintf(stderr,"\t-n N\tNODEMAX, auto fills TIMEMAX (default %d)\n", limits.nodemax);
+	fprintf(stderr,"\t-e list\tscore evaluators name:weight,.. of conn word density compact adj (default conn)\n");
+	fprintf(stderr,"\t-m N\tmemory cap in MB (default none)\n");
+	fprintf(stderr,"\t-j N\tworker threads (default %d)\n", limits.threads);
+	fprintf(stderr,"\t-W N\tgrid width (default %d)\n", limits.width);
+	fprintf(stderr,"\t-H N\tgrid height (default %d)\n", limits.height);
+	fprintf(stderr,"\t-b N\tbatch, solve N word lists at a time\n");
+	fprintf(stderr,"\t-l\tbatch input names word list files\n");
+	fprintf(stderr,"\t-S path\tserve requests on Unix socket\n");
+	fprintf(stderr,"\t-P N\tportfolio, race N configurations (max %d)\n", PORTFOLIOMAX);
+	fprintf(stderr,"\t-c file\tcheckpoint to file, also on SIGTERM\n");
+	fprintf(stderr,"\t-k N\trounds between checkpoints (default %d)\n", limits.checkrounds);
+	fprintf(stderr,"\t-r file\tresume from checkpoint\n");
+	fprintf(stderr,"\t-J file\ttelemetry, JSON record per round\n");
+        exit(1);
+}
 
 /*
- * Timer logic
+ * Checkpoint and stop on SIGTERM, the solve notices between two nodes
  */
-void sigAlarm(int s) {
-	ticks++;
-	alarm(1);
-}
 
+void on_sigterm(int sig) {
+	(void) sig;
+	terminated = 1;
+}
 
 /*
- * Elapsed time for diagnostics
+ * Streaming, emit every improved solution as a record: a header line followed
+ * by the grid and an empty line. Stops the solve when arg can't be written.
  */
-char *elapsedstr(void) {
-	static char line[40];
 
-	sprintf(line, "%02d:%02d", ticks / 60, ticks % 60);
-	return line;
+int print_solution(struct jigsaw *js, void *arg) {
+	struct jigsaw_result result;
+	FILE *f = (FILE *) arg;
+
+	jigsaw_result(js, &result);
+	fprintf(f, "solution word:%d score:%f time:%.3f\n", result.numword, result.score, result.elapsed);
+	jigsaw_print(js, f);
+	fprintf(f, "\n");
+	fflush(f);
+	return ferror(f) != 0;
 }
 
 /*
- * Display the grid. Show disgnostics info in verbose mode
+ * Open the next word list of the batch. Lists are either named one per line
+ * or follow each other separated by empty lines. Returns 0 at the end, *f is
+ * NULL if the named list cannot be opened.
  */
 
-void dump_grid(struct node *d) {
-	int x, y, cnt, attr;
-
-	if (opt_debug == 2) {
-		// Double check the number of words
-		cnt = 0;
-		for (x = GRIDXMAX * GRIDYMAX - 1; x >= 0; x--)
-			if (ISCHAR(d->grid[x])) {
-				if (!ISCHAR(d->grid[x - 1]) && ISCHAR(d->grid[x + 1])) cnt++;
-				if (!ISCHAR(d->grid[x - GRIDXMAX]) && ISCHAR(d->grid[x + GRIDXMAX])) cnt++;
-			}
-		printf("%s seqnr:%d level:%d/%d score:%f numword:%d/%d numchar:%d numconn:%d\n",
-		       elapsedstr(), d->seqnr, d->firstlevel, d->lastlevel, d->score, d->numword,
-		       cnt, d->numchar, d->numconn);
+int next_list(FILE **pf) {
+	char line[4096], *text = NULL;
+	size_t size = 0;
+	FILE *f;
+	int len;
+
+	if (opt_manifest) {
+		while (fgets(line, sizeof(line), batchin)) {
+			line[strcspn(line, "\r\n")] = 0;
+			if (line[0] == 0)
+				continue;
+			if ((*pf = fopen(line, "r")) == NULL)
+				fprintf(stderr, "Cannot open %s\n", line);
+			return 1;
+		}
+		return 0;
 	}
 
-	if (opt_debug == 2) {
-		// Show grid as I would like to see it
-		for (y = 0; y < GRIDYMAX; y++) {
-			for (x = 0; x < GRIDXMAX; x++) {
-				attr = d->attr[x + y * GRIDXMAX] & (TODOH | TODOV);
-				if (attr == (TODOH | TODOV))
-					printf("B");
-				else if (attr == TODOH)
-					printf("H");
-				else if (attr == TODOV)
-					printf("V");
-				else
-					printf(".");
-			}
-			printf(" ");
-			for (x = 0; x < GRIDXMAX; x++)
-				if (ISSTAR(d->grid[x + y * GRIDXMAX]))
-					printf("*");
-				else if (ISFREE(d->grid[x + y * GRIDXMAX]))
-					printf(".");
-				else if (ISCHAR(d->grid[x + y * GRIDXMAX]))
-					printf("%c", d->grid[x + y * GRIDXMAX] + BASE);
-				else
-					printf("0x%02x", d->grid[x + y * GRIDXMAX]);
-			printf("\n");
-		}
-	} else {
-		// Show grid as Fred would like to see it
-		for (y = 1; y < GRIDYMAX - 1; y++) {
-			for (x = 1; x < GRIDXMAX - 1; x++)
-				if (ISCHAR(d->grid[x + y * GRIDXMAX]))
-					printf("%c", d->grid[x + y * GRIDXMAX] + BASE);
-				else
-					printf("-");
-			printf("\n");
+	// Collect the lines up to an empty line
+	f = open_memstream(&text, &size);
+	if (f == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	while (fgets(line, sizeof(line), batchin)) {
+		len = strspn(line, " \t\r\n");
+		if (line[len] == 0) {
+			if (ftell(f) == 0)
+				continue; // Leading empty lines
+			break;
 		}
+		fputs(line, f);
+	}
+	fclose(f);
+	if (size == 0) {
+		free(text);
+		return 0;
 	}
 
-	// For diagnostics
-	fflush(stdout);
+	// Text is released when the list is closed
+	f = fmemopen(NULL, size, "w+");
+	if (f == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	fwrite(text, 1, size, f);
+	rewind(f);
+	free(text);
+	*pf = f;
+	return 1;
 }
 
 /*
- * Get a node, reusing free'ed nodes.
+ * Batch solver. Each solver keeps one context, so node memory stays warm
+ * while only the word list is reloaded.
  */
 
-struct node *mallocnode(void) {
-	struct node *d;
+void *solver_main(void *arg) {
+	struct jigsaw *js = NULL;
+	struct jigsaw_result result;
+	FILE *f, *out;
+	const char *msg;
+	char *text;
+	size_t size;
+	int n, error;
 
-	d = freenode;
-	if (d == NULL) {
-		d = (struct node *) malloc(sizeof(struct node));
-		nummalloc++;
-	} else
-		freenode = d->next;
+	(void) arg;
+	for (;;) {
+		// Claim the next list
+		pthread_mutex_lock(&batchmutex);
+		if (batcheof || !next_list(&f)) {
+			batcheof = 1;
+			pthread_cond_broadcast(&batchcond);
+			pthread_mutex_unlock(&batchmutex);
+			break;
+		}
+		if (numpuzzle == maxpuzzle) {
+			maxpuzzle = maxpuzzle ? 2 * maxpuzzle : 256;
+			puzzles = (struct puzzle *) realloc(puzzles, maxpuzzle * sizeof(struct puzzle));
+			if (puzzles == NULL) {
+				fprintf(stderr, "Out of memory\n");
+				exit(1);
+			}
+		}
+		n = numpuzzle++;
+		puzzles[n].done = 0;
+		pthread_mutex_unlock(&batchmutex);
+
+		// Solve
+		msg = NULL;
+		if (f == NULL) {
+			msg = "Cannot open";
+		} else {
+			if (js == NULL)
+				js = jigsaw_create(f, &error);
+			else
+				error = jigsaw_load(js, f);
+			fclose(f);
+			if (error != JIGSAW_OK) {
+				// No context or word list, so no result either
+				msg = jigsaw_strerror(error);
+			} else {
+				error = jigsaw_solve(js, &limits, NULL, NULL);
+				if (error < 0 && error != JIGSAW_ENOMEM)
+					msg = jigsaw_strerror(error);
+			}
+		}
 
-	if (d == NULL) {
-		fprintf(stderr, "Out of memory after %d nodes (%d bytes)\n", nummalloc, (int)(nummalloc * sizeof(struct node)));
-		dump_grid(&solution);
-		exit(0);
+		// Output record: a header line followed by the grid and an empty line
+		out = open_memstream(&text, &size);
+		if (out == NULL) {
+			fprintf(stderr, "Out of memory\n");
+			exit(1);
+		}
+		if (msg) {
+			fprintf(out, "list:%d error:%s\n", n + 1, msg);
+		} else {
+			jigsaw_result(js, &result);
+			fprintf(out, "list:%d word:%d score:%f time:%.3f\n", n + 1, result.numword, result.score, result.elapsed);
+			jigsaw_print(js, out);
+		}
+		fprintf(out, "\n");
+		fclose(out);
+
+		pthread_mutex_lock(&batchmutex);
+		puzzles[n].text = text;
+		puzzles[n].done = 1;
+		pthread_cond_broadcast(&batchcond);
+		pthread_mutex_unlock(&batchmutex);
 	}
 
-	return d;
+	if (js)
+		jigsaw_destroy(js);
+	return NULL;
 }
 
-void add_node(struct node *d) {
+void run_batch(void) {
+	pthread_t tid[opt_batch];
+	char *text;
 	int i;
-	struct node **prev, *next;
-
-	// Evaluate grids score
-	d->score = (float) d->numconn / d->numchar;
 
-	// Insert grid into sorted list, eliminating duplicates
-	i = (int)(d->score * (SCOREMAX - 1));
-	if (i < 0) i = 0;
-	if (i >= SCOREMAX) i = SCOREMAX - 1;
-	prev = &scores[i];
-	next = scores[i];
-	for (;;) {
-		if (next == NULL) break;
-		if (d->score > next->score) break;
-		if (d->score == next->score && d->hash >= next->hash) break;
-		prev = &next->next;
-		next = next->next;
+	for (i = 0; i < opt_batch; i++) {
+		if (pthread_create(&tid[i], NULL, solver_main, NULL)) {
+			fprintf(stderr, "Cannot create thread\n");
+			exit(1);
+		}
 	}
 
-	// Test if entry is duplicate
-	while (next && d->score == next->score && d->hash == next->hash) {
-		hashtst++;
-		if (memcmp(d->grid, next->grid, sizeof(d->grid)) == 0) {
-			d->next = freenode;
-			freenode = d;
-			return;
+	// Print in input order as soon as a result is in
+	for (i = 0;; i++) {
+		pthread_mutex_lock(&batchmutex);
+		while (!(i < numpuzzle && puzzles[i].done) && !(batcheof && i >= numpuzzle))
+			pthread_cond_wait(&batchcond, &batchmutex);
+		if (i >= numpuzzle) {
+			pthread_mutex_unlock(&batchmutex);
+			break;
 		}
-		hashhit++;
-		prev = &next->next;
-		next = next->next;
+		text = puzzles[i].text;
+		pthread_mutex_unlock(&batchmutex);
+
+		fputs(text, stdout);
+		fflush(stdout);
+		free(text);
 	}
 
-	// Diagnostics
-	if (opt_dump > 1)
-		dump_grid(d);
-
-	// Enter grid into list
-	d->seqnr = seqnr++;
-	d->next = next;
-	(*prev) = d;
-	if (d->numadj == 0)
-		numnode++;
-	realnumnode++;
+	for (i = 0; i < opt_batch; i++)
+		pthread_join(tid[i], NULL);
+	free(puzzles);
 }
 
-
 /*
- * The next two routines test if a given word can be placed in the grid.
- * If a new character will be adjacent to an existing character, check
- * if the newly formed character pair exist in the wordlist (it doesn't
- * matter where).
+ * Portfolio member, solves the word list with its own configuration
  */
 
-int test_hword(struct node *d, int xybase, int word) {
-	uint8_t *p, *grid;
-	int l;
-
-	// Some basic tests
-	if (xybase < 0 || xybase + wlen[word] >= GRIDXMAX * GRIDYMAX)
-		return 0;
+void *member_main(void *arg) {
+	struct member *m = (struct member *) arg;
+	FILE *f;
 
-	if (opt_symmetrical) {
-		// How about star's
-		if (ISCHAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - xybase]))
-			return 0;
-		if (ISCHAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - (xybase + wlen[word] - 1)]))
-			return 0;
+	f = fmemopen(listtext, listsize, "r");
+	if (f == NULL) {
+		m->error = JIGSAW_ENOMEM;
+		return NULL;
 	}
+	m->js = jigsaw_create(f, &m->error);
+	fclose(f);
+	if (m->js)
+		m->error = jigsaw_solve(m->js, &m->limits, NULL, NULL);
+	return NULL;
+}
 
-	// Will new characters create conflicts
-	for (grid = d->grid + xybase, p = wordbase[word]; *p; grid++, p++) {
-		if (*grid == *p)
-			continue; // Char already there
-		if (!ISFREE(*grid))
-			return 0; // Char placement conflict
-		if (ISSTAR(*p))
-			continue; // Skip stars
-		if (!ISCHAR(grid[-GRIDXMAX]) && !ISCHAR(grid[+GRIDXMAX]))
-			continue; // No adjacent chars
-
-		if (!ISCHAR(grid[-GRIDXMAX]))
-			l = links2[*p][grid[+GRIDXMAX]];
-		else if (!ISCHAR(grid[+GRIDXMAX]))
-			l = links2[grid[-GRIDXMAX]][*p];
-		else
-			l = links3[grid[-GRIDXMAX]][*p][grid[+GRIDXMAX]];
-		if (l == 0)
-			return 0;
-	}
+/*
+ * Race the portfolio configurations within the same time limit. They share
+ * the best word count so far, grids that can't beat it are dropped. The grid
+ * with the most words wins, every member's outcome is reported on stderr.
+ */
 
-	// Word can be placed
-	return 1;
-}
+void run_portfolio(FILE *in) {
+	struct jigsaw_result result;
+	struct member *m, *winner = NULL;
+	char line[4096];
+	FILE *f;
+	int i, best = 0;
 
-int test_vword(struct node *d, int xybase, int word) {
-	uint8_t *p, *grid;
-	int l;
+	// Every member loads the same text
+	f = open_memstream(&listtext, &listsize);
+	if (f == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	while (fgets(line, sizeof(line), in))
+		fputs(line, f);
+	fclose(f);
+	if (listsize == 0) {
+		fprintf(stderr, "Empty word list\n");
+		exit(1);
+	}
 
-	// Some basic tests
-	if (xybase < 0 || xybase + wlen[word] * GRIDXMAX >= GRIDXMAX * GRIDYMAX)
-		return 0;
+	for (i = 0; i < opt_portfolio; i++) {
+		m = &portfolio[i];
+		m->limits = limits;
+		m->limits.nodemax = (int) (limits.nodemax * m->nodemax);
+		if (limits.nodemax > 0 && m->limits.nodemax < 1)
+			m->limits.nodemax = 1; // Small NODEMAX must not turn auto
+		m->limits.start = m->start;
+		m->limits.startmin = m->startmin;
+		m->limits.weight = m->weight;
+		m->limits.incumbent = &incumbent;
+		if (pthread_create(&m->tid, NULL, member_main, m)) {
+			fprintf(stderr, "Cannot create thread\n");
+			exit(1);
+		}
+	}
 
-	if (opt_symmetrical) {
-		// How about star's
-		if (ISCHAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - xybase]))
-			return 0;
-		if (ISCHAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - (xybase + wlen[word] * GRIDXMAX - GRIDXMAX)]))
-			return 0;
+	for (i = 0; i < opt_portfolio; i++) {
+		m = &portfolio[i];
+		pthread_join(m->tid, NULL);
+		if (m->js == NULL || (m->error < 0 && m->error != JIGSAW_ENOMEM)) {
+			fprintf(stderr, "%s\n", jigsaw_strerror(m->error));
+			exit(m->error == JIGSAW_ELONG ? 0 : 1);
+		}
+		jigsaw_result(m->js, &result);
+		if (winner == NULL || result.numword > best) {
+			winner = m;
+			best = result.numword;
+		}
 	}
 
-	// Will new characters create conflicts
-	for (grid = d->grid + xybase, p = wordbase[word]; *p; grid += GRIDXMAX, p++) {
-		if (*grid == *p)
-			continue; // Char already there
-		if (!ISFREE(*grid))
-			return 0; // Char placement conflict
-		if (ISSTAR(*p))
-			continue; // Skip stars
-		if (!ISCHAR(grid[-1]) && !ISCHAR(grid[+1]))
-			continue; // No adjacent characters
-
-		if (!ISCHAR(grid[-1]))
-			l = links2[*p][grid[+1]];
-		else if (!ISCHAR(grid[+1]))
-			l = links2[grid[-1]][*p];
-		else
-			l = links3[grid[-1]][*p][grid[+1]];
-		if (l == 0)
-			return 0;
+	for (i = 0; i < opt_portfolio; i++) {
+		m = &portfolio[i];
+		jigsaw_result(m->js, &result);
+		fprintf(stderr, "member:%d nodemax:%d start:%d startmin:%d weight:%.2f word:%d score:%f%s\n",
+			i, m->limits.nodemax, m->start, m->startmin, m->weight, result.numword, result.score,
+			m == winner ? " winner" : "");
 	}
+	jigsaw_print(winner->js, stdout);
 
-	// Word can be placed
-	return 1;
+	for (i = 0; i < opt_portfolio; i++)
+		jigsaw_destroy(portfolio[i].js);
+	free(listtext);
 }
 
-
 /*
- * The next two routines will place a given word in the grid. These routines
- * also performs several sanity checks to make sure the new grid is worth
- * it to continue with. If a newly placed character is adjacent to an
- * existing character, then that pair must be part of a word that can
- * be physically placed. If multiple character pairs exist, then no check
- * is done to determine if those words (of which the pairs are part) can
- * be adjacent. That is done later as these grids are not counted against
- * NODEMAX.
+ * Hash of a word list, FNV-1a. 0 is reserved for no list.
  */
 
-int place_hword(struct node *data, int xybase, int word) {
-	struct node *d = data;
-	uint8_t *p, *grid, *attr;
-	int i, l, xy;
-	int newnumadj;
-	struct link *ld;
-
-	// Can word be placed
-	if (INSET(d->words, word)) return 0;
-	if (xybase < 0 || xybase + wlen[word] >= GRIDXMAX * GRIDYMAX + 1) return 0;
-
-	if (opt_symmetrical) {
-		// How about star's
-		if (ISCHAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - xybase]))
-			return 0;
-		if (ISCHAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - (xybase + wlen[word] - 1)]))
-			return 0;
-	}
+uint64_t hash_list(const char *text, size_t size) {
+	uint64_t h = 0xcbf29ce484222325ULL;
+	size_t i;
 
-	// check character environment
-	newnumadj = d->numadj;
-	for (xy = xybase, grid = d->grid + xy, p = wordbase[word]; *p; grid++, xy++, p++) {
-		if (*grid == *p)
-			continue; // Char already there
-		if (!ISFREE(*grid))
-			return 0; // Char placement conflict
-		if (ISSTAR(*p))
-			continue; // Skip stars
-		if (!ISCHAR(grid[-GRIDXMAX]) && !ISCHAR(grid[+GRIDXMAX]))
-			continue; // No adjacent chars
-
-		if (ISFREE(grid[-GRIDXMAX])) {
-			d->adjxy[newnumadj] = xy;
-			d->adjl[newnumadj] = links2[*p][grid[+GRIDXMAX]];
-		} else if (ISFREE(grid[+GRIDXMAX])) {
-			d->adjxy[newnumadj] = xy - GRIDXMAX;
-			d->adjl[newnumadj] = links2[grid[-GRIDXMAX]][*p];
-		} else {
-			d->adjxy[newnumadj] = xy - GRIDXMAX;
-			d->adjl[newnumadj] = links3[grid[-GRIDXMAX]][*p][grid[+GRIDXMAX]];
-		}
-		if (d->adjl[newnumadj] == 0 || newnumadj == ADJMAX - 1)
-			return 0;
-		d->adjdir[newnumadj++] = 'V';
-	}
+	for (i = 0; i < size; i++)
+		h = (h ^ (uint8_t) text[i]) * 0x100000001b3ULL;
+	return h ? h : 1;
+}
 
-	// Test if new adj's really exist
-	for (i = d->numadj; i < newnumadj; i++) {
-		for (l = d->adjl[i]; l; l = ld->next) {
-			ld = &linkdat[l];
-			if (test_vword(d, d->adjxy[i] + ld->ofs * GRIDXMAX, ld->w))
-				break;
-		}
-		if (l == 0) return 0;
-		d->adjl[i] = l;
-	}
+/*
+ * Check out a context holding the word list. The cache holds at least one
+ * context per server thread, so an idle one is always available.
+ */
 
-	// Get a new grid
-	d = mallocnode();
-	memcpy(d, data, sizeof(struct node));
-
-	// Place word
-	BITSET(d->words, word);
-	d->numword++;
-	d->numadj = newnumadj;
-	for (xy = xybase, grid = d->grid + xy, attr = d->attr + xy, p = wordbase[word];
-	     *p;
-	     grid++, attr++, xy++, p++) {
-		if (!ISSTAR(*p)) {
-			*attr &= ~TODOH;
-
-			// Remove character pair hints that are part of the new word
-			for (i = 0; i < d->numadj; i++)
-				if (d->adjdir[i] == 'H' && d->adjxy[i] == xy) {
-					d->adjdir[i] = d->adjdir[--d->numadj];
-					d->adjxy[i] = d->adjxy[d->numadj];
-					d->adjl[i] = d->adjl[d->numadj];
-					break; // There can be only one
-				}
-
-			// Place character
-			if (ISFREE(*grid)) {
-				d->hash += (123456 + xy) * (123456 - *p); // Neat, isn't it?
-				*attr |= TODOV;
-				d->numchar++;
-			} else {
-				d->numconn++;
-			}
+struct cached *checkout(char *text, size_t size, int *error) {
+	struct cached *c, *lru = NULL;
+	uint64_t hash = hash_list(text, size);
+	FILE *f;
+	int i;
+
+	pthread_mutex_lock(&cachemutex);
+	for (i = 0; i < numcache; i++) {
+		c = &cache[i];
+		if (c->busy)
+			continue;
+		if (c->hash == hash) {
+			lru = c;
+			break;
 		}
-		*grid = *p;
+		if (lru == NULL || c->lastuse < lru->lastuse)
+			lru = c;
 	}
-
-	// Update hotspot
-	if (xy2level[xy - 1] > d->lastlevel)
-		d->lastlevel = xy2level[xy - 1];
-
-	if (opt_symmetrical) {
-		// Don't forget the symmetry
-		if (d->symdir == 0) {
-			d->symdir = 'H';
-			d->symxy = GRIDXMAX * GRIDYMAX - 1 - (xybase + wlen[word] - 1);
-			d->symlen = wlen[word];
-		} else
-			d->symdir = 0;
+	lru->busy = 1;
+	lru->lastuse = ++cacheclock;
+	pthread_mutex_unlock(&cachemutex);
+
+	*error = JIGSAW_OK;
+	if (limits.debug)
+		fprintf(stderr, "list:%016llx cached:%d\n", (unsigned long long) hash, lru->hash == hash);
+	if (lru->hash == hash)
+		return lru;
+
+	// Load into the least recently used context
+	lru->hash = 0;
+	f = fmemopen(text, size, "r");
+	if (f == NULL) {
+		*error = JIGSAW_ENOMEM;
+		return lru;
 	}
+	if (lru->js == NULL)
+		lru->js = jigsaw_create(f, error);
+	else
+		*error = jigsaw_load(lru->js, f);
+	fclose(f);
+	if (*error == JIGSAW_OK)
+		lru->hash = hash;
+	return lru;
+}
 
-	// Save grid
-	add_node(d);
-	return 1;
+void checkin(struct cached *c) {
+	pthread_mutex_lock(&cachemutex);
+	c->busy = 0;
+	pthread_mutex_unlock(&cachemutex);
 }
 
-int place_vword(struct node *data, int xybase, int word) {
-	struct node *d = data;
-	uint8_t *p, *grid, *attr;
-	int i, xy, l;
-	int newnumadj;
-	struct link *ld;
-
-	// Some basic tests
-	if (INSET(d->words, word)) return 0;
-	if (xybase < 0 || xybase + wlen[word] * GRIDXMAX >= GRIDXMAX * GRIDYMAX + GRIDXMAX) return 0;
-
-	if (opt_symmetrical) {
-		// How about star's
-		if (ISCHAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - xybase]))
-			return 0;
-		if (ISCHAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - (xybase + wlen[word] * GRIDXMAX - GRIDXMAX)]))
-			return 0;
-	}
+/*
+ * Set the time limit from seconds, fractions allowed, or milliseconds with
+ * an "ms" suffix. Returns non-zero when it isn't a time.
+ */
 
-	// Check character environment
-	newnumadj = d->numadj;
-	for (xy = xybase, grid = d->grid + xy, p = wordbase[word]; *p; grid += GRIDXMAX, xy += GRIDXMAX, p++) {
-		if (*grid == *p)
-			continue; // Char already there
-		if (!ISFREE(*grid))
-			return 0; // Char placement conflict
-		if (ISSTAR(*p))
-			continue; // Skip stars
-		if (!ISCHAR(grid[-1]) && !ISCHAR(grid[+1]))
-			continue; // No adjacent chars
-
-		if (ISFREE(grid[-1])) {
-			d->adjxy[newnumadj] = xy;
-			d->adjl[newnumadj] = links2[*p][grid[+1]];
-		} else if (ISFREE(grid[+1])) {
-			d->adjxy[newnumadj] = xy - 1;
-			d->adjl[newnumadj] = links2[grid[-1]][*p];
-		} else {
-			d->adjxy[newnumadj] = xy - 1;
-			d->adjl[newnumadj] = links3[grid[-1]][*p][grid[+1]];
-		}
-		if (d->adjl[newnumadj] == 0 || newnumadj == ADJMAX - 1)
-			return 0;
-		d->adjdir[newnumadj++] = 'H';
-	}
+int parse_time(const char *arg, struct jigsaw_limits *l) {
+	char *end;
+	double secs;
+
+	secs = strtod(arg, &end);
+	if (strcmp(end, "ms") == 0)
+		secs /= 1000;
+	else if (*end && strcmp(end, "s") != 0)
+		return 1;
+	if (end == arg || secs < 0 || secs > 2000000)
+		return 1;
+
+	l->timemax = 0;
+	l->timemaxms = (int) (secs * 1000 + 0.5);
+	if (secs > 0 && l->timemaxms == 0)
+		l->timemaxms = 1;
+	return 0;
+}
+
+/*
+ * Set the score evaluators from name:weight pairs separated by commas, a name
+ * alone weighs 1. Evaluators not named don't count. Returns non-zero when it
+ * isn't a list of evaluators.
+ */
 
-	// Test if new adj's really exist
-	for (i = d->numadj; i < newnumadj; i++) {
-		for (l = d->adjl[i]; l; l = ld->next) {
-			ld = &linkdat[l];
-			if (test_hword(d, d->adjxy[i] + ld->ofs, ld->w))
+int parse_eval(const char *arg, struct jigsaw_limits *l) {
+	const char *name;
+	char *end;
+	float eval[JIGSAW_EVALMAX], sum = 0;
+	int i, len;
+
+	memset(eval, 0, sizeof(eval));
+	for (; *arg; arg++) {
+		len = strcspn(arg, ":,");
+		for (i = 0; (name = jigsaw_evalname(i)); i++)
+			if ((int) strlen(name) == len && strncmp(arg, name, len) == 0)
 				break;
+		if (name == NULL)
+			return 1;
+		arg += len;
+		eval[i] = 1;
+		if (*arg == ':') {
+			eval[i] = strtod(arg + 1, &end);
+			if (end == arg + 1 || eval[i] < 0)
+				return 1;
+			arg = end;
 		}
-		if (l == 0) return 0;
-		d->adjl[i] = l;
+		sum += eval[i];
+		if (*arg != ',' || arg[1] == 0)
+			break;
 	}
+	if (*arg || !(sum > 0))
+		return 1;
 
-	// Get a new grid
-	d = mallocnode();
-	memcpy(d, data, sizeof(struct node));
-
-	// Place word
-	BITSET(d->words, word);
-	d->numword++;
-	d->numadj = newnumadj;
-	for (xy = xybase, grid = d->grid + xy, attr = d->attr + xy, p = wordbase[word];
-	     *p;
-	     grid += GRIDXMAX, attr += GRIDXMAX, xy += GRIDXMAX, p++) {
-		if (!ISSTAR(*p)) {
-			*attr &= ~TODOV;
-
-			// Remove character pair hints that are part of the new word
-			for (i = 0; i < d->numadj; i++)
-				if (d->adjdir[i] == 'V' && d->adjxy[i] == xy) {
-					d->adjdir[i] = d->adjdir[--d->numadj];
-					d->adjxy[i] = d->adjxy[d->numadj];
-					d->adjl[i] = d->adjl[d->numadj];
-					break; // There can be only one
-				}
-
-			// Place character
-			if (ISFREE(*grid)) {
-				*attr |= TODOH;
-				d->hash += (123456 + xy) * (123456 - *p); // Neat, isn't it?
-				d->numchar++;
-			} else {
-				d->numconn++;
-			}
-		}
-		*grid = *p;
-	}
+	memcpy(l->eval, eval, sizeof(eval));
+	return 0;
+}
 
-	// Update hotspot
-	if (xy2level[xy - GRIDXMAX] > d->lastlevel)
-		d->lastlevel = xy2level[xy - GRIDXMAX];
-
-	if (opt_symmetrical) {
-		// Don't forget the symmetry
-		if (d->symdir == 0) {
-			d->symdir = 'V';
-			d->symxy = GRIDXMAX * GRIDYMAX - 1 - (xybase + wlen[word] * GRIDXMAX - GRIDXMAX);
-			d->symlen = wlen[word];
-		} else
-			d->symdir = 0;
-	}
+/*
+ * Parse a whole number from min up to max. Returns non-zero when it isn't
+ * one.
+ */
 
-	// Save grid
-	add_node(d);
-	return 1;
-}
+int parse_int(const char *arg, int min, int max, int *val) {
+	char *end;
+	long v;
 
+	errno = 0;
+	v = strtol(arg, &end, 10);
+	if (end == arg || *end || errno || v < min || v > max)
+		return 1;
+	*val = (int) v;
+	return 0;
+}
 
 /*
- * Scan a grid and place a word. To supress an exponential growth of
- * generated grids, we can be very fussy when chosing which word to
- * place. I have chosen to fill the grid from top-left to bottom-right
- * making sure the newly placed words fit tightly to the already placed
- * words. If this is not possible, then I choose just one word such that
- * the first letter is nearest to the start of the hotspot regeon.
- * This sounds easy but it took me quite some time to figure it out.
+ * Apply the options of a request line. Returns non-zero for unknown options
+ * and invalid values.
  */
 
-void scan_grid(struct node *d) {
-	uint8_t *grid, *attr;
-	int xy, l, cnt, tstxy, level, w;
-	struct link *ld;
-	int hasplace, hasfree;
-
-	if (opt_symmetrical) {
-		// Don't forget the symmetry
-		if (d->symdir == 'H') {
-			for (w = numword - 1; w >= 0; w--)
-				if (!INSET(d->words, w) && wlen[w] == d->symlen)
-					place_hword(d, d->symxy, w);
-			return;
-		}
-		if (d->symdir == 'V') {
-			for (w = numword - 1; w >= 0; w--)
-				if (!INSET(d->words, w) && wlen[w] == d->symlen)
-					place_vword(d, d->symxy, w);
-			return;
-		}
-	}
+int parse_request(char *line, struct jigsaw_limits *req) {
+	char *opt, *arg, *save;
 
-	// locate unaccounted adjacent cells
-	if (d->numadj > 0) {
-		xy = d->adjxy[--d->numadj];
-		if (d->adjdir[d->numadj] == 'H') {
-			for (l = d->adjl[d->numadj]; l; l = ld->next) {
-				ld = &linkdat[l];
-				place_hword(d, xy + ld->ofs, ld->w);
-			}
-		} else {
-			for (l = d->adjl[d->numadj]; l; l = ld->next) {
-				ld = &linkdat[l];
-				place_vword(d, xy + ld->ofs * GRIDXMAX, ld->w);
-			}
+	for (opt = strtok_r(line, " \t\r\n", &save); opt; opt = strtok_r(NULL, " \t\r\n", &save)) {
+		if (strcmp(opt, "-s") == 0) {
+			req->symmetrical = 1;
+			continue;
 		}
-		return;
-	}
-
-	// Nominate grid for final result
-	if (d->numword > solution.numword)
-		memcpy(&solution, d, sizeof(struct node));
-
-	// Sweep grid from top-left to bottom-right corner
-	for (level = d->firstlevel; level <= d->lastlevel && level <= GRIDXMAX + GRIDYMAX - 4; level++) {
-
-		if (!opt_symmetrical) {
-			// Locate 'tight' words
-			hasplace = 0;
-			for (xy = level2xy[level], grid = d->grid + xy, attr = d->attr + xy;
-			     !ISBORDER(*attr);
-			     xy += GRIDXMAX - 1, grid += GRIDXMAX - 1, attr += GRIDXMAX - 1) {
-				if (*attr & TODOH) {
-					for (l = links1[*grid]; l; l = ld->next) {
-						ld = &linkdat[l];
-						tstxy = xy + ld->ofs;
-						if (xy2level[tstxy] == d->firstlevel)
-							hasplace += place_hword(d, tstxy, ld->w);
-					}
-				}
-				if (*attr & TODOV) {
-					for (l = links1[*grid]; l; l = ld->next) {
-						ld = &linkdat[l];
-						tstxy = xy + ld->ofs * GRIDXMAX;
-						if (xy2level[tstxy] == d->firstlevel)
-							hasplace += place_vword(d, tstxy, ld->w);
-					}
-				}
-				if (hasplace)
-					return;
-			}
+		if (strcmp(opt, "-C") == 0) {
+			req->cputime = 1;
+			continue;
 		}
-
-		// Locate 'adjacent' word
-		hasplace = 0;
-		for (xy = level2xy[level], grid = d->grid + xy, attr = d->attr + xy;
-		     !ISBORDER(*attr);
-		     xy += GRIDXMAX - 1, grid += GRIDXMAX - 1, attr += GRIDXMAX - 1) {
-			if (*attr & TODOH) {
-				for (l = links1[*grid]; l; l = ld->next) {
-					ld = &linkdat[l];
-					tstxy = xy + ld->ofs;
-					if (ISSTAR(d->grid[tstxy]))
-						hasplace += place_hword(d, tstxy, ld->w);
-					if (opt_symmetrical) {
-						if (ISSTAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - (tstxy + wlen[ld->w] - 1)]))
-							hasplace += place_hword(d, tstxy, ld->w);
-					}
-				}
-			}
-			if (*attr & TODOV) {
-				for (l = links1[*grid]; l; l = ld->next) {
-					ld = &linkdat[l];
-					tstxy = xy + ld->ofs * GRIDXMAX;
-					if (ISSTAR(d->grid[tstxy]))
-						hasplace += place_vword(d, tstxy, ld->w);
-					if (opt_symmetrical) {
-						if (ISSTAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - (tstxy + wlen[ld->w] * GRIDXMAX - GRIDXMAX)]))
-							hasplace += place_vword(d, tstxy, ld->w);
-					}
-				}
-			}
-			if (hasplace)
-				return;
+		if (strcmp(opt, "-I") == 0) {
+			req->improve = 1;
+			continue;
 		}
-
-		// Locate word fragments (just one word please)
-		hasplace = 0;
-		hasfree = 0;
-		for (xy = level2xy[level], grid = d->grid + xy, attr = d->attr + xy;
-		     !ISBORDER(*attr);
-		     xy += GRIDXMAX - 1, grid += GRIDXMAX - 1, attr += GRIDXMAX - 1) {
-			if (ISFREE(*grid))
-				hasfree = 1;
-			if (*attr & TODOH) {
-				cnt = 0;
-				for (l = links1[*grid]; l; l = ld->next) {
-					ld = &linkdat[l];
-					tstxy = xy + ld->ofs;
-					if (!ISSTAR(d->grid[tstxy]))
-						cnt += place_hword(d, tstxy, ld->w);
-					if (!opt_symmetrical) {
-						if (cnt != 0)
-							break;
-					}
-				}
-				if (cnt == 0) {
-					// Speed things up (Not 100% correct, but it's fast)
-					*attr &= ~TODOH;
-					grid[-1] = STAR;
-					grid[+1] = STAR;
-					if (opt_symmetrical) {
-						if (ISCHAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - (xy - 1)])) return; // Arghh
-						d->grid[GRIDXMAX * GRIDYMAX - 1 - (xy - 1)] = STAR;
-						if (ISCHAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - (xy + 1)])) return; // Arghh
-						d->grid[GRIDXMAX * GRIDYMAX - 1 - (xy + 1)] = STAR;
-					}
-				}
-				hasplace += cnt;
-			}
-			if (*attr & TODOV) {
-				cnt = 0;
-				for (l = links1[*grid]; l; l = ld->next) {
-					ld = &linkdat[l];
-					tstxy = xy + ld->ofs * GRIDXMAX;
-					if (!ISSTAR(d->grid[tstxy]))
-						cnt += place_vword(d, tstxy, ld->w);
-					if (!opt_symmetrical) {
-						if (cnt != 0)
-							break;
-					}
-				}
-				if (cnt == 0) {
-					// Speed things up (Not 100% correct, but it's fast)
-					*attr &= ~TODOV;
-					grid[-GRIDXMAX] = STAR;
-					grid[+GRIDXMAX] = STAR;
-					if (opt_symmetrical) {
-						if (ISCHAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - (xy - GRIDXMAX)])) return; // Arghh
-						d->grid[GRIDXMAX * GRIDYMAX - 1 - (xy - GRIDXMAX)] = STAR;
-						if (ISCHAR(d->grid[GRIDXMAX * GRIDYMAX - 1 - (xy + GRIDXMAX)])) return; // Arghh
-						d->grid[GRIDXMAX * GRIDYMAX - 1 - (xy + GRIDXMAX)] = STAR;
-					}
-				}
-				hasplace += cnt;
-			}
-			if (hasplace)
-				return;
+		if (strlen(opt) != 2 || opt[0] != '-' || strchr("tnmWHe", opt[1]) == NULL)
+			return 1;
+		if ((arg = strtok_r(NULL, " \t\r\n", &save)) == NULL)
+			return 1;
+		switch (opt[1]) {
+		case 't':
+			if (parse_time(arg, req))
+				return 1;
+			break;
+		case 'n':
+			if (strcmp(arg, "auto") == 0)
+				req->nodemax = 0;
+			else if (parse_int(arg, 1, INT_MAX, &req->nodemax))
+				return 1;
+			break;
+		case 'm':
+			if (parse_int(arg, 0, INT_MAX, &req->memmax))
+				return 1;
+			break;
+		case 'W':
+			if (parse_int(arg, 2, JIGSAW_GRIDMAX, &req->width))
+				return 1;
+			break;
+		case 'H':
+			if (parse_int(arg, 2, JIGSAW_GRIDMAX, &req->height))
+				return 1;
+			break;
+		case 'e':
+			if (parse_eval(arg, req))
+				return 1;
+			break;
 		}
-
-		// Update hotspot
-		if (!hasfree)
-			d->firstlevel = level + 1;
 	}
+	return 0;
 }
 
-void kick_ass(void) {
-	struct node *d, *todonode;
-	int i;
+/*
+ * Serve one request. It is a line of options followed by the word list up
+ * to an empty line or the end of input. The response is a record for every
+ * improved solution, as with -i, and a final "result" or "error" record.
+ */
 
-	for (;;) {
-		// setup up some debugging statistics
-		realnumnode = numnode = numscan = 0;
-		hashtst = hashhit = 0;
-
-		// gather all nodes into a single list with highest score first
-		d = todonode = NULL;
-		for (i = SCOREMAX - 1; i >= 0; i--)
-			if (scores[i]) {
-				if (todonode == NULL)
-					d = todonode = scores[i];
-				else
-					d->next = scores[i];
-				while (d->next) d = d->next;
-				scores[i] = NULL;
-			}
+void serve(int fd) {
+	struct jigsaw_limits req;
+	struct jigsaw_result result;
+	struct cached *c;
+	FILE *in, *out, *list;
+	char line[4096], *text = NULL;
+	const char *msg = NULL;
+	size_t size = 0;
+	int error;
+
+	in = fdopen(fd, "r");
+	out = fdopen(dup(fd), "w");
+	list = open_memstream(&text, &size);
+	if (in == NULL || out == NULL || list == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
 
-		// Ok babe, lets go!!!
-		while (todonode) {
-			d = todonode;
-			todonode = d->next;
-			if (d->numadj > 0 || numnode < opt_nodemax) {
-				if (d->numadj == 0) numscan++;
-				scan_grid(d);
-			}
-			d->next = freenode;
-			freenode = d;
+	// Read the request
+	req = limits;
+	if (fgets(line, sizeof(line), in) == NULL || parse_request(line, &req))
+		msg = "Invalid request";
+	while (msg == NULL && fgets(line, sizeof(line), in)) {
+		if (line[strspn(line, " \t\r\n")] == 0)
+			break;
+		fputs(line, list);
+	}
+	fclose(list);
+	if (msg == NULL && size == 0)
+		msg = "Empty word list";
+
+	// Solve
+	if (msg == NULL) {
+		c = checkout(text, size, &error);
+		if (error != JIGSAW_OK)
+			msg = jigsaw_strerror(error);
+		else
+			error = jigsaw_solve(c->js, &req, print_solution, out);
+		if (msg == NULL && error < 0 && error != JIGSAW_ENOMEM)
+			msg = jigsaw_strerror(error);
+		if (msg == NULL) {
+			jigsaw_result(c->js, &result);
+			fprintf(out, "result word:%d score:%f time:%.3f\n", result.numword, result.score, result.elapsed);
+			jigsaw_print(c->js, out);
+			fprintf(out, "\n");
 		}
+		checkin(c);
+	}
+	if (msg)
+		fprintf(out, "error:%s\n\n", msg);
 
-		// Test for timeouts
-		if (opt_timemax && ticks >= opt_timemax) {
-			// PRINT OUT YOUR SOLUTION BEFORE YOU GO!
-			/*
-			 * HELP, the algorithm must compleet well under 10 minutes.
-			 */
-			dump_grid(&solution);
-			exit(0);
-		}
+	fclose(out);
+	fclose(in);
+	free(text);
+}
 
-		if (opt_debug) {
-			fprintf(stderr, "%s word:%2d score:%f level:%2d/%2d node:%4d/%4d/%4d hash:%3d/%3d\n",
-				elapsedstr(), solution.numword, solution.score,
-				solution.firstlevel, solution.lastlevel, numscan, numnode,
-				realnumnode, hashtst, hashhit);
-			if (opt_dump) dump_grid(&solution);
-		}
+void *server_main(void *arg) {
+	int fd;
 
-		// Ass kicked?
-		if (realnumnode == 0)
-			break;
+	(void) arg;
+	for (;;) {
+		fd = accept(listenfd, NULL, NULL);
+		if (fd >= 0)
+			serve(fd);
 	}
+	return NULL;
 }
 
+/*
+ * Daemon mode, serve requests on a Unix socket. -b sets the number of
+ * requests served at a time.
+ */
 
-void load_words(char *fname) {
-	char line[80], c;
-	FILE *f;
-	int i, w, done;
-	uint8_t *p;
+void run_service(void) {
+	struct sockaddr_un addr;
+	pthread_t tid;
+	int i, numserver;
+
+	numserver = opt_batch ? opt_batch : 1;
+	numcache = numserver < CACHEMIN ? CACHEMIN : numserver;
+	cache = (struct cached *) calloc(numcache, sizeof(struct cached));
+	if (cache == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
 
-	// Open file and load the words and check if they are valid
-	if (fname) {
-		f = fopen(fname, "r");
-		if (!f) {
-			fprintf(stderr, "Cannot open %s\n", fname);
-			exit(1);
-		}
-	} else {
-		f = stdin;
+	// Clients may go away while their grids are written
+	signal(SIGPIPE, SIG_IGN);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(opt_socket) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Socket name too long\n");
+		exit(1);
 	}
-	for (numword = 0;;) {
-		// Read line
-		fgets(line, sizeof(line), f);
-		if (feof(f))
-			break;
-		// Copy the word
-		i = 0;
-		wordbase[numword][i++] = STAR;
-		for (; isalpha(c = line[i - 1]); i++)
-			wordbase[numword][i] = (uint8_t) (isupper(c) ? tolower(c) - BASE : c - BASE);
-		wordbase[numword][i++] = STAR;
-		wordbase[numword][i] = 0;
-		wlen[numword] = i;
-		if (i > WORDLENMAX - 2) {
-			fprintf(stderr, "Word too long\n");
-			exit(0);
-		}
-		if (i > 2) {
-			if (numword == WORDMAX - 1) {
-				fprintf(stderr, "Too many words\n");
-				exit(0);
-			} else
-				numword++;
-		}
+	strcpy(addr.sun_path, opt_socket);
+	unlink(opt_socket);
+	listenfd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenfd < 0 || bind(listenfd, (struct sockaddr *) &addr, sizeof(addr)) || listen(listenfd, 64)) {
+		fprintf(stderr, "Cannot listen on %s\n", opt_socket);
+		exit(1);
 	}
-	fclose(f);
 
-	if (opt_debug)
-		fprintf(stderr, "%s Loaded %d words\n", elapsedstr(), numword);
-
-	/*
-	 * Calculate links. These are indexes on the wordlist which are used
-	 * to quickly locate 1,2,3 long letter sequences within the words.
-	 */
-	numlinkdat = 1;
-	memset(links1, 0, sizeof(links1));
-	memset(links2, 0, sizeof(links2));
-	memset(links3, 0, sizeof(links3));
-	for (i = 0, done = 0; !done && i < WORDLENMAX; i++) {
-		done = 1;
-		for (w = numword - 1; w >= 0; w--) {
-			p = wordbase[w];
-			if (i >= 0 && i <= wlen[w] - 3) {
-				// With delimiters
-				linkdat[numlinkdat].w = w;
-				linkdat[numlinkdat].ofs = -i;
-				linkdat[numlinkdat].next = links3[p[i + 0]][p[i + 1]][p[i + 2]];
-				links3[p[i + 0]][p[i + 1]][p[i + 2]] = numlinkdat++;
-				done = 0;
-			}
-			if (i >= 0 && i <= wlen[w] - 2) {
-				// With delimiters
-				linkdat[numlinkdat].w = w;
-				linkdat[numlinkdat].ofs = -i;
-				linkdat[numlinkdat].next = links2[p[i + 0]][p[i + 1]];
-				links2[p[i + 0]][p[i + 1]] = numlinkdat++;
-				done = 0;
-			}
-			if (i > 0 && i <= wlen[w] - 2) {
-				// Without delimiters
-				linkdat[numlinkdat].w = w;
-				linkdat[numlinkdat].ofs = -i;
-				linkdat[numlinkdat].next = links1[p[i]];
-				links1[p[i]] = numlinkdat++;
-				done = 0;
-			}
+	// Main thread is server 0
+	for (i = 1; i < numserver; i++) {
+		if (pthread_create(&tid, NULL, server_main, NULL)) {
+			fprintf(stderr, "Cannot create thread\n");
+			exit(1);
 		}
+		pthread_detach(tid);
 	}
-
-	if (opt_debug)
-		fprintf(stderr, "%s Found %d links\n", elapsedstr(), numlinkdat);
-}
-
-void usage(char ** argv)
-{
-        fprintf(stderr,"usage: %s [<wordlist>]\n", argv[0]);
-	fprintf(stderr,"\t-h\thelp\n");
-	fprintf(stderr,"\t-s\tsymmetrical\n");
-	fprintf(stderr,"\t-t N\tTIMEMAX (default %d)\n", opt_timemax);
-	fprintf(stderr,"\t-n N\tNODEMAX (default %d)\n", opt_nodemax);
-        exit(1);
+	server_main(NULL);
 }
 
 int main(int argc, char **argv) {
-	struct node *d;
-	int x, y, i, w;
-	int opt;
+	struct jigsaw *js = NULL;
+	FILE *f;
+	int opt, error;
 
-	if (opt_debug)
-		fprintf(stderr, "sizeof(node)=%d\n", (int)sizeof(struct node));
+	jigsaw_limits_init(&limits);
 
-	while ((opt = getopt(argc, argv, "hst:n:dD")) != -1) {
+	while ((opt = getopt(argc, argv, "hsit:CIn:e:m:j:W:H:b:lS:P:c:k:r:J:dD")) != -1) {
 		switch (opt) {
 		case 'h':
 			usage(argv);
 			break;
 		case 's':
-			opt_symmetrical = 1;
+			limits.symmetrical = 1;
+			break;
+		case 'i':
+			opt_stream = 1;
 			break;
 		case 't':
-			opt_timemax = atoi(optarg);
+			if (parse_time(optarg, &limits)) {
+				fprintf(stderr, "Time must be seconds or milliseconds\n");
+				exit(1);
+			}
+			break;
+		case 'C':
+			limits.cputime = 1;
+			break;
+		case 'I':
+			limits.improve = 1;
 			break;
 		case 'n':
-			opt_nodemax = atoi(optarg);
+			limits.nodemax = strcmp(optarg, "auto") == 0 ? 0 : atoi(optarg);
+			if (limits.nodemax < 1 && strcmp(optarg, "auto") != 0) {
+				fprintf(stderr, "NODEMAX must be positive or auto\n");
+				exit(1);
+			}
+			break;
+		case 'e':
+			if (parse_eval(optarg, &limits)) {
+				fprintf(stderr, "Evaluators must be name:weight,.. with a positive weight\n");
+				exit(1);
+			}
+			break;
+		case 'm':
+			limits.memmax = atoi(optarg);
+			if (limits.memmax < 0) {
+				fprintf(stderr, "Memory cap must be 0 (none) or more MB\n");
+				exit(1);
+			}
+			break;
+		case 'j':
+			limits.threads = atoi(optarg);
+			if (limits.threads < 1 || limits.threads > JIGSAW_THREADMAX) {
+				fprintf(stderr, "Threads must be 1..%d\n", JIGSAW_THREADMAX);
+				exit(1);
+			}
+			break;
+		case 'W':
+			limits.width = atoi(optarg);
+			break;
+		case 'H':
+			limits.height = atoi(optarg);
 			break;
 		case 'd':
-			opt_debug++;
+			limits.debug++;
 			break;
 		case 'D':
-			opt_dump++;
+			limits.dump++;
+			break;
+		case 'b':
+			opt_batch = atoi(optarg);
+			if (opt_batch < 1 || opt_batch > JIGSAW_THREADMAX) {
+				fprintf(stderr, "Batch must be 1..%d\n", JIGSAW_THREADMAX);
+				exit(1);
+			}
+			break;
+		case 'l':
+			opt_manifest = 1;
+			break;
+		case 'S':
+			opt_socket = optarg;
+			break;
+		case 'P':
+			opt_portfolio = atoi(optarg);
+			if (opt_portfolio < 1 || opt_portfolio > PORTFOLIOMAX) {
+				fprintf(stderr, "Portfolio must be 1..%d\n", PORTFOLIOMAX);
+				exit(1);
+			}
+			break;
+		case 'c':
+			limits.checkpoint = optarg;
+			break;
+		case 'k':
+			limits.checkrounds = atoi(optarg);
+			if (limits.checkrounds < 0) {
+				fprintf(stderr, "Checkpoint rounds must be positive\n");
+				exit(1);
+			}
+			break;
+		case 'r':
+			opt_resume = optarg;
+			break;
+		case 'J':
+			opt_telemetry = optarg;
 			break;
 		default: /* '?' */
 			usage(argv);
 		}
 	}
 
-	// start the timer
-	signal(SIGALRM, sigAlarm);
-	alarm(1);
-
-	// Load the word list
-	load_words(argc<optind ? NULL : argv[optind++]);
+	if (limits.width < 2 || limits.width > JIGSAW_GRIDMAX || limits.height < 2 || limits.height > JIGSAW_GRIDMAX) {
+		fprintf(stderr, "Grid size must be 2..%d\n", JIGSAW_GRIDMAX);
+		exit(1);
+	}
+	if (limits.nodemax == 0 && limits.timemax == 0 && limits.timemaxms == 0) {
+		fprintf(stderr, "NODEMAX auto needs a time limit\n");
+		exit(1);
+	}
+	if ((opt_batch || opt_portfolio) && opt_stream) {
+		fprintf(stderr, "Streaming is not available in batch or portfolio mode\n");
+		exit(1);
+	}
 
-	// init grid administration
-	freenode = NULL;
+	if ((opt_batch || opt_portfolio || opt_socket) && (limits.checkpoint || opt_resume)) {
+		fprintf(stderr, "Checkpoints are not available in batch, portfolio or service mode\n");
+		exit(1);
+	}
+	if (limits.checkpoint) {
+		limits.terminate = &terminated;
+		signal(SIGTERM, on_sigterm);
+	}
 
-	// create an initial grid
-	d = (struct node *) calloc(1, sizeof(struct node));
-	for (y = GRIDYMAX - 1; y >= 0; y--) {
-		for (x = GRIDXMAX - 1; x >= 0; x--) {
-			d->grid[x + y * GRIDXMAX] = STAR;
-			d->attr[x + y * GRIDXMAX] = BORDER;
-		}
+	if ((opt_batch || opt_portfolio || opt_socket) && opt_telemetry) {
+		fprintf(stderr, "Telemetry is not available in batch, portfolio or service mode\n");
+		exit(1);
 	}
-	for (y = GRIDYMAX - 2; y > 0; y--) {
-		for (x = GRIDXMAX - 2; x > 0; x--) {
-			d->grid[x + y * GRIDXMAX] = FREE;
-			d->attr[x + y * GRIDXMAX] = 0;
+	if (opt_telemetry) {
+		limits.telemetry = fopen(opt_telemetry, "w");
+		if (!limits.telemetry) {
+			fprintf(stderr, "Cannot open %s\n", opt_telemetry);
+			exit(1);
 		}
 	}
 
-	// Do some hotspot pre-calculations to fast skip empty grid areas
-	// with rectangular grids it's easier to track the start of scan diagonals instead of calfculating them
-	for (i = 0; i < GRIDXMAX * GRIDYMAX; i++) {
-		int lvl = (i % GRIDXMAX) + (i / GRIDXMAX);
-		// xy -> level
-		xy2level[i] = lvl;
-		// level -> xy
-		if (!ISBORDER(d->attr[i]) && !level2xy[lvl])
-			level2xy[lvl] = i;
+	if (opt_socket) {
+		run_service();
+		exit(0);
 	}
 
-	// Place all the words for starters
-	if (opt_symmetrical) {
-		// work from the middle out
-		for (w = numword - 1; w >= 0; w--)
-			if (wlen[w] >= 5) {
-				d->hash = 0;
-				place_hword(d, (GRIDXMAX / 2 + 2 - wlen[w]) + (GRIDYMAX / 2) * GRIDXMAX, w);
-			}
-	} else {
-		// work from top-left to bottom-right
-		for (w = numword - 1; w >= 0; w--) {
-			d->firstlevel = 2;
-			place_hword(d, 0 + 1 * GRIDXMAX, w);
+	// Load the word list, a checkpoint brings its own
+	if (opt_resume) {
+		f = fopen(opt_resume, "rb");
+		if (!f) {
+			fprintf(stderr, "Cannot open %s\n", opt_resume);
+			exit(1);
+		}
+		js = jigsaw_restore(f, &limits, &error);
+		fclose(f);
+	} else if (optind < argc) {
+		f = fopen(argv[optind], "r");
+		if (!f) {
+			fprintf(stderr, "Cannot open %s\n", argv[optind]);
+			exit(1);
 		}
+	} else {
+		f = stdin;
+	}
+	if (opt_batch) {
+		batchin = f;
+		run_batch();
+		fclose(f);
+		exit(0);
+	}
+	if (opt_portfolio) {
+		run_portfolio(f);
+		fclose(f);
+		exit(0);
+	}
+	if (!opt_resume) {
+		js = jigsaw_create(f, &error);
+		fclose(f);
+	}
+	if (js == NULL) {
+		fprintf(stderr, "%s\n", jigsaw_strerror(error));
+		exit(error == JIGSAW_ELONG ? 0 : 1);
 	}
-
-	d->next = freenode;
-	freenode = d;
 
 	// Here we go
-	kick_ass();
-	dump_grid(&solution);
-
+	error = jigsaw_solve(js, &limits, opt_stream ? print_solution : NULL, stdout);
+	if (error < 0)
+		fprintf(stderr, "%s\n", jigsaw_strerror(error));
+	if (error == JIGSAW_EINVAL || error == JIGSAW_ETHREAD || error == JIGSAW_EFORMAT)
+		exit(1);
+	jigsaw_print(js, stdout);
+
+	if (limits.telemetry)
+		fclose(limits.telemetry);
+	jigsaw_destroy(js);
 	exit(0);
 }
@@ -0,0 +1,149 @@
+/*
+   jigsaw, to create crossword puzzle grids
+   Copyright 1996 https://github.com/xyzzy
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef JIGSAW_H
+#define JIGSAW_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * libjigsaw, the solver as a library. A context is created from a word list
+ * and keeps the word list, its link index and the node memory warm, so it
+ * can run any number of solves. A context must not be used by two threads at
+ * the same time, different contexts are independent.
+ *
+ *	js = jigsaw_create(f, &error);
+ *	jigsaw_limits_init(&limits);
+ *	limits.timemax = 10;
+ *	error = jigsaw_solve(js, &limits, NULL, NULL);
+ *	jigsaw_result(js, &result);
+ *	jigsaw_destroy(js);
+ */
+
+#define JIGSAW_GRIDMAX	128				// Max. width/height of grid
+#define JIGSAW_THREADMAX 256				// Max. # worker threads
+
+// Score evaluators, each rates a grid 0..1 with higher better
+#define JIGSAW_EVAL_CONN	0				// Connections per character
+#define JIGSAW_EVAL_WORD	1				// Words per character
+#define JIGSAW_EVAL_DENSITY	2				// Characters per cell up to the hotspot
+#define JIGSAW_EVAL_COMPACT	3				// Part of the grid beyond the hotspot
+#define JIGSAW_EVAL_ADJ		4				// Few pairs left to complete
+#define JIGSAW_EVALMAX	5
+
+// Return codes
+#define JIGSAW_OK	0				// Search completed
+#define JIGSAW_TIMEOUT	1				// Time is up, result is the best so far
+#define JIGSAW_STOPPED	2				// Callback asked to stop
+#define JIGSAW_ENOMEM	(-1)				// Out of memory, result is the best so far
+#define JIGSAW_EINVAL	(-2)				// Invalid limits
+#define JIGSAW_ELONG	(-3)				// Word too long
+#define JIGSAW_ETHREAD	(-4)				// Cannot create thread
+#define JIGSAW_EIO	(-5)				// Cannot write checkpoint
+#define JIGSAW_EFORMAT	(-6)				// Invalid checkpoint
+
+struct jigsaw;
+
+struct jigsaw_limits {
+	int	width, height;				// Grid size
+	int	nodemax;				// Grids kept per round, 0=Auto within the time limit
+	int	timemax;				// Seconds, 0=None
+	int	timemaxms;				// Milliseconds, instead of timemax when set
+	int	cputime;				// Time limit is 0=Wall clock 1=CPU time of the solve
+	int	memmax;					// Node memory cap in MB, 0=None
+	int	threads;				// # worker threads
+	int	symmetrical;				// 0=No 1=Yes
+	int	debug;					// 0=Off 1=On 2=Verbose, on stderr
+	int	dump;					// 0=No 1=after every round 2=after every addNode
+	int	start;					// Start words 0=Top-left 1=Centre
+	int	startmin;				// Min. length of start words
+	float	weight;					// Score of a word in connections, 0=None
+	int	*incumbent;				// Best # words shared by a portfolio, NULL=None
+	const char *checkpoint;				// Checkpoint file, NULL=None
+	int	checkrounds;				// Rounds between checkpoints, 0=Only when terminated
+	volatile int *terminate;			// Checkpoint and stop once set, NULL=None
+	FILE	*telemetry;				// JSON record per round, NULL=None
+	int	improve;				// Spend the time left improving the solution
+	float	eval[JIGSAW_EVALMAX];			// Weight per score evaluator
+};
+
+struct jigsaw_result {
+	int		numword;			// # words placed
+	float		score;				// Score of the grid
+	double		elapsed;			// Seconds since the solve started
+	int		width, height;			// Grid size
+	const char	*grid;				// width*height cells row by row, '-' is empty
+	int		rounds;				// # rounds
+	long		nodes;				// # grids scanned
+	long		hashtst, hashhit;		// Duplicate compares, false positives
+};
+
+/*
+ * jigsaw_load() replaces the word list of a context, when it fails the
+ * context has an empty word list.
+ * jigsaw_solve() calls callback, when given, for every improved solution.
+ * jigsaw_result() and jigsaw_print() show it, a non-zero return stops the
+ * solve. Strings returned by jigsaw_result() live until the next solve.
+ *
+ * With a checkpoint file the round is saved every checkrounds rounds, and
+ * when *terminate is set, which a signal handler may do, the solve saves the
+ * round and stops. jigsaw_restore() creates a context from a checkpoint and
+ * sets the options it was made with in limits, the next jigsaw_solve()
+ * continues the round. Time is counted from the restore.
+ *
+ * The time limit is checked while grids are scanned. When the time left would
+ * not fit a full round, rounds are narrowed below nodemax. With nodemax 0
+ * each round is sized to fill the time limit. CPU time is that of
+ * the threads of the solve, other contexts in the process don't count.
+ *
+ * With a telemetry stream every round ends with a JSON record on a line of
+ * its own: timings, node counts, the occupancy of the score buckets, node
+ * memory and histograms of the scan time and number of children per grid.
+ *
+ * With improve, the time left once the search is done goes to the solution.
+ * Words in a window of the grid are taken out and put back by a narrow beam
+ * that may place words anywhere they cross, sparse windows first, until no
+ * window improves or time is up. Symmetrical grids are left as they are.
+ *
+ * The score that decides which grids survive a round is the weighted mean of
+ * the evaluators in eval[], by default connections only. weight adds words
+ * to the connections of JIGSAW_EVAL_CONN. jigsaw_evalname() returns the name
+ * of an evaluator, NULL past the last.
+ */
+struct jigsaw *jigsaw_create(FILE *f, int *error);
+int jigsaw_load(struct jigsaw *js, FILE *f);
+struct jigsaw *jigsaw_restore(FILE *f, struct jigsaw_limits *limits, int *error);
+void jigsaw_limits_init(struct jigsaw_limits *limits);
+int jigsaw_solve(struct jigsaw *js, const struct jigsaw_limits *limits,
+		 int (*callback)(struct jigsaw *js, void *arg), void *arg);
+void jigsaw_result(struct jigsaw *js, struct jigsaw_result *result);
+void jigsaw_print(struct jigsaw *js, FILE *f);
+void jigsaw_destroy(struct jigsaw *js);
+const char *jigsaw_strerror(int error);
+const char *jigsaw_evalname(int eval);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,3977 @@
+/*
+   jigsaw, to create crossword puzzle grids
+   Copyright 1996 https://github.com/xyzzy
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "jigsaw.h"
+
+#define GRIDMAX		JIGSAW_GRIDMAX			// Max. width/height of grid
+#define WORDLENMAX	64				// # length of word incl. delimiters
+#define ADJMAX		128				// # unaccounted adjacent chars
+#define SCOREMAX	1000				// Spead for sorting
+#define HASHMIN		4096				// Initial size of duplicate table
+#define THREADMAX	JIGSAW_THREADMAX		// # worker threads
+#define BATCHNODES	64				// # nodes per thread per batch
+#define POOLCHUNK	64				// # nodes moved per free list refill
+#define POOLSTEP	64				// Granularity of stored node sizes, one cache line
+#define POOLMAX		64				// # free lists, larger nodes use malloc()
+#define SLABSIZE	(2 << 20)			// Node slots are carved from slabs, one huge page
+#define CKMAGIC		"JIGSAWC3"			// Checkpoint signature and version
+#define CKBUFSIZE	(1 << 16)			// Checkpoint write buffer
+#define CKSUMINIT	0xcbf29ce484222325ULL		// FNV-1a offset basis
+#define HISTMAX		32				// # log2 bins of telemetry histograms
+#define POLLSTEP	64				// # polls inside scan_grid() per clock reading
+#define AUTOSTART	1000				// Auto NODEMAX: width of the first round
+#define AUTOMIN		64				// Auto NODEMAX: narrowest round
+#define AUTOMAX		(1 << 20)			// Auto NODEMAX: widest round
+#define IMPROVEWIDTH	256				// Improvement: grids kept per round
+#define PAIRFACTOR	64				// Grids with pairs kept per round, times NODEMAX
+#define MEMSHARE	2				// Memory cap: 1/MEMSHARE of it for grids of the next round
+
+#define BASE		('a'-1)				// Word conversion
+#define STAR		(28)				// Word delimiters
+#define CUTOFF		(29)				// Fill: free cell of a region bordering no character
+#define REACHED		(30)				// Fill: free cell of a region bordering one
+#define FREE		(31)				// Unoccupied grid cell
+#define TODOH		1				// Hint: Hor. word can be here
+#define TODOV		2				// Hint: Ver. word can be here
+#define BORDER		4				// Cell is grid border
+
+#define ISSTAR(C)	((C)==STAR)			// Test the above
+#define ISFREE(C)	((C)==FREE)
+#define ISCHAR(C)	((C)< STAR)
+#define ISBORDER(C)	((C)&BORDER)
+
+#define BITSET(M, B) ((M)[(B)>>3] |=  (1<<((B)&7)))	// BitSet manipulation
+#define BITCLR(M, B) ((M)[(B)>>3] &= ~(1<<((B)&7)))
+#define INSET(M, B)  ((M)[(B)>>3] &   (1<<((B)&7)))
+
+struct adj {
+	int32_t		l;				// Pair's wordlist
+	int16_t		xy;				// Pair's location
+	int8_t		dir;				// Pair's direction
+};
+
+/*
+ * Nodes in scores[] are stored compact: the header followed by the numadj
+ * pair hints and nummark grid marks. A stored grid is the grid of its parent,
+ * plus the marks scan_grid() made on the parent before the word was placed,
+ * plus the placed word. Full nodes, as used for scanning, additionally carry
+ * the complete grid and for them parent is the stored node they were
+ * expanded from.
+ */
+struct node {
+	struct node	*next;				//
+	struct node	*parent;			// Grid is relative to this one
+	int		refcnt;				// # children, +1 while listed
+	int		pool;				// Free list it belongs to
+	int		seqnr;				// For diagnostics
+	int		numword, numchar, numconn;	// Statistics
+	int		numfree;			// # free cells that can still get a character
+	uint64_t	hash;				// Duplicate detection
+	int		firstlevel, lastlevel;		// Grids hotspot
+	float		score;				// Will it survive?
+	int8_t		symdir;				// Force symmetry
+	int16_t		symxy;				//
+	int16_t		symlen;				//
+	int8_t		dir;				// Placed word
+	int16_t		xy;				//
+	int32_t		word;				//
+	int		nummark;			// # grid marks
+	int		numadj;				// # unprocessed char pairs
+	struct adj	adj[ADJMAX];			// Pairs, stored nodes: followed by marks
+	uint8_t		grid[];				// *THE* grid, followed by grid hints
+};
+
+#define NODESIZE(N)	(offsetof(struct node, adj) + (N) * sizeof(struct adj))	// Stored node with N pairs/marks
+#define ATTR(D)		((D)->grid + js->gridsize)		// Grid hints
+#define ZOBRIST(XY, C)	js->zobrist[(XY) * 32 + (C)]	// Hash key of character at cell
+#define TGRID(D)	((D)->grid + 2 * js->gridsize)	// Full nodes: grid transposed, columns are lines
+#define MARKS(D)	((struct adj *)((D)->grid + js->markofs))	// Full nodes: marks since expanded
+#define WORDS(D)	((D)->grid + js->wordsofs)		// Full nodes: set of placed words
+#define FILL(D)		((int16_t *)((D)->grid + js->fillofs))	// Full nodes: cells of cut_off()
+
+struct link {
+	int32_t next;
+	int32_t w;					// What's the word
+	int16_t ofs;					// Were's in the word
+	uint8_t prev, post;				// links1: characters either side
+};
+
+// Duplicate detection
+struct hashent {
+	uint64_t	hash;
+	int		stats;				// numchar and numconn
+	struct node	*d;				// NULL if unused, EVICTED if node was evicted
+};
+
+static struct node evicted;				// Keeps probe chains intact, never matches
+#define EVICTED		(&evicted)
+
+#define HASHSTATS(D)	((D)->numchar << 16 | (D)->numconn)	// Same grids have same stats
+
+/*
+ * Worker administration. A round is split into batches of todo nodes which
+ * are scanned concurrently. Children are collected per todo node and merged
+ * into scores[] in the original order, so the outcome equals a serial run.
+ */
+struct job {
+	struct node	*d;				// Node to scan
+	struct node	*child, **childtail;		// Generated grids in order
+	struct node	*best;				// Nomination for solution
+	int		numreject;			// # grids that did not make the cut
+	int		numnode;			// # of those without pairs, they count against NODEMAX
+	int		numchild;			// # grids generated, stored or not
+	long		scanns;				// Nanoseconds scanning, telemetry only
+};
+
+struct worker {
+	struct jigsaw	*js;				// Context it works for
+	pthread_t	tid;
+	struct node	*freenode[POOLMAX];		// Private free lists
+	struct node	*scratch;			// Expanded node being scanned
+	long		cpubase;			// Thread CPU clock when the solve started
+	long		cputime;			// Nanoseconds of CPU used since
+};
+
+/*
+ * Solver context. The word list, its links and the node memory live as long
+ * as the context, everything else is set up by each solve.
+ */
+struct jigsaw {
+	// Configuring parameters
+	int opt_debug;					// 0=Off 1=On 2=Verbose
+	int opt_symmetrical;				// 0=No 1=Yes
+	int opt_dump;					// 0=No 1=after every round 2=after every addNode
+	long opt_timemax;				// Nanoseconds, 0=None
+	int opt_cputime;				// 0=Wall clock 1=CPU time of the solve
+	int opt_nodemax;				// 500=Fast 1500=Normal 0=Auto
+	int opt_threads;				// # worker threads
+	int opt_width;					// Grid width
+	int opt_height;					// Grid height
+	int opt_memmax;					// Node memory cap in MB, 0=None
+	int opt_start;					// 0=Top-left 1=Centre
+	int opt_startmin;				// Min. length of start words
+	float opt_weight;				// Score of a word in connections
+	int *opt_incumbent;				// Shared best # words, NULL=None
+	FILE *opt_telemetry;				// JSON record per round, NULL=None
+	int opt_improve;				// Spend the time left improving the solution
+	float opt_eval[JIGSAW_EVALMAX];			// Weight per score evaluator
+
+	// The external word list
+	uint8_t *wordarena;				// Converted words back to back
+	uint8_t **wordbase;				// Converted wordlist
+	int *wlen;					// Length of words
+	int numword;					// How many
+	int wordsetsize;				// # bytes in a set of words
+
+	// Where are 1,2,3 long character combinations
+	int32_t links1[32];				// 1-char wordlist
+	int32_t links2[32][32];				// 2-char wordlist
+	int32_t links3[32][32][32];			// 3-char wordlist
+	struct link *linkdat;				// Body above wordlist
+	int numlinkdat, maxlinkdat;			// How many
+	uint32_t fitmask[32][32];			// Characters that fit between two cells
+
+	// Grid geometry
+	int gridxmax, gridymax;				// Size of grid incl. border
+	int gridsize;					// # cells incl. border
+	int nodesize;					// sizeof(struct node) incl. grid
+	int scratchsize;				// nodesize incl. room for marks
+	int markofs;					// Offset of marks in full node grid
+	int wordsofs;					// Offset of word set in full node grid
+	int fillofs;					// Offset of cut_off() cells in full node grid
+
+	// Hotspot pre-calculations
+	int16_t *xy2level;				// distance 0,0 to x,y
+	int16_t *level2xy;				// inverse
+	int16_t *xy2txy;				// Cell in transposed grid
+	int *levelarea;					// # cells up to level
+	int area;					// # cells of the grid
+
+	// Scoring, evaluators with a weight
+	int numeval;					// How many, 0=Connections only
+	int evalidx[JIGSAW_EVALMAX];			// JIGSAW_EVAL_*
+	float evalweight[JIGSAW_EVALMAX];		// Share in the score
+
+	// Node administration
+	struct node *freenode[POOLMAX];			// Don't malloc() too much
+	uint8_t *slabptr;				// Next free slot in current slab
+	int slabfree;					// # bytes left in current slab
+	void **slabs;					// All slabs, for jigsaw_destroy()
+	int numslab, maxslab;				// How many
+	long memused;					// # bytes in live nodes
+	struct node *rootnode;				// Empty grid all nodes descend from
+	struct node *cmpnode[2];			// Expanded nodes for add_node()
+	int numnode, realnumnode;			// Statistics
+	struct node *solution;				// What are we doing?
+	struct node *scores[SCOREMAX];			// Grids of next round by score
+	struct node **scoretail[SCOREMAX];		// Append point of scores[]
+	float scorelo, scorescale;			// Bucket layout of the round
+
+	// Bounded frontier, only the best NODEMAX grids without pairs are kept
+	// and the best PAIRFACTOR*NODEMAX grids with pairs. [0] is without pairs
+	int bucketcnt[2][SCOREMAX];			// # grids per bucket
+	int cutbucket[2];				// Lower buckets are rejected
+	int numfrontier[2];				// # grids from cutbucket up
+	long frontiermem;				// # bytes of those grids
+	int numreject;					// Statistics
+
+	// Branch and bound
+	int *maxmore;					// Max. # words fitting in capacity
+	int *maxhalf;					// Same, half their characters on free cells
+	int incumbent;					// # words to beat
+	int numprune;					// Statistics
+
+	// Duplicate detection
+	struct hashent *hashtab;			// Open addressing, current round
+	uint64_t *zobrist;				// Key per cell and character
+	int hashsize, hashused;				// # entries
+
+	// Diagnostics
+	int seqnr;
+	int hashtst, hashhit;				// Grid compares, false positives
+	int nummalloc;					// # node slots created
+	long nummallocbytes;				// # bytes of slabs and large nodes
+	int numscan;
+	int totround;					// Totals of the solve, for jigsaw_result()
+	long totscan, tothashtst, tothashhit;
+	char timestr[40];				// elapsedstr()
+
+	// Telemetry of the round
+	int numchild;					// # grids generated, stored or not
+	int numdup;					// # duplicates dropped
+	double roundstart;				// Seconds into the solve
+	long scanns;					// Nanoseconds scanning
+	long mempeak;					// Most bytes in live nodes
+	long scanhist[HISTMAX];				// Grids by log2 scan nanoseconds
+	long childhist[HISTMAX];			// Grids by log2 # children
+
+	// Deadline
+	int nodemax;					// NODEMAX of the round, narrowed when time runs out
+	int autowidth;					// Auto NODEMAX of the next round
+	int timeout;					// Time is up, seen by all threads
+	long roundused;					// Time used when the round started
+	long lasttime;					// Time the last round took
+	int lastnode;					// # grids without pairs it generated
+
+	// Improvement of the solution once the search is done
+	int improving;					// Words may be placed anywhere
+
+	// What's left
+	struct timespec start;				// Start of solve
+	int error;					// Solve aborted, JIGSAW_E*
+	int stop;					// Callback asked to stop
+	int (*callback)(struct jigsaw *js, void *arg);	// Improved solution
+	void *arg;
+	char *resultgrid;				// jigsaw_result()
+
+	// Workers
+	struct worker workers[THREADMAX];
+	int numworker;					// # threads started
+	struct job *jobs;				// Current batch
+	int numjob, nextjob, donejob;			// Batch progress
+	int batchnr, batchopen;				// Batch generation
+	int numactive;					// Workers inside run_jobs()
+	int skipscan;					// Skip nodes without adjacencies
+	int quit;					// Workers must exit
+	pthread_mutex_t poolmutex;			// Guards freenode and batch
+	pthread_cond_t batchcond;			// New batch available
+	pthread_cond_t donecond;			// Batch completed
+
+	// Checkpoints
+	const char *opt_checkpoint;			// Checkpoint file, NULL=None
+	int opt_checkrounds;				// Rounds between checkpoints, 0=Only when terminated
+	volatile int *opt_terminate;			// Checkpoint and stop when set, NULL=None
+	int numround;					// # rounds completed
+	struct ckent *cknodes;				// Nodes written so far
+	int numckid, maxckid;				// How many
+	struct jigsaw_limits resume;			// Options of a restored checkpoint
+	char *resumedata;				// Frontier of a restored checkpoint, until the solve
+	size_t resumesize;				// # bytes
+	struct node *resumetodo;			// Nodes the checkpointed round had left
+	int resumed;					// Continue the checkpointed round
+};
+
+static __thread struct worker *curworker;		// NULL for serial runs
+static __thread struct job *curjob;			// Job being scanned
+static __thread int pollcnt;				// Polls until the clock is read
+
+/*
+ * Timer logic, seconds since the solve started
+ */
+static double elapsed(struct jigsaw *js) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - js->start.tv_sec) + (now.tv_nsec - js->start.tv_nsec) / 1e9;
+}
+
+/*
+ * Monotonic nanoseconds, for telemetry
+ */
+static long nsecs(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+/*
+ * Nanoseconds of CPU used by the calling thread
+ */
+static long thread_cpu(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+/*
+ * Nanoseconds the solve used by the clock of the time limit. CPU time is
+ * summed over the threads of the solve, each thread updates its own share
+ * when it reads the clock.
+ */
+static long time_used(struct jigsaw *js) {
+	struct worker *w;
+	long sum = 0;
+	int i;
+
+	if (!js->opt_cputime)
+		return (long) (elapsed(js) * 1e9);
+
+	w = curworker ? curworker : &js->workers[0];
+	__atomic_store_n(&w->cputime, thread_cpu() - w->cpubase, __ATOMIC_RELAXED);
+	for (i = 0; i < js->opt_threads; i++)
+		sum += __atomic_load_n(&js->workers[i].cputime, __ATOMIC_RELAXED);
+	return sum;
+}
+
+/*
+ * Test if time is up, once it is all threads see it
+ */
+
+static int out_of_time(struct jigsaw *js) {
+	if (__atomic_load_n(&js->timeout, __ATOMIC_RELAXED))
+		return 1;
+	if (js->opt_timemax && time_used(js) >= js->opt_timemax) {
+		__atomic_store_n(&js->timeout, 1, __ATOMIC_RELAXED);
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Cheap test for use inside scan_grid(), the clock is read every POLLSTEP
+ * calls so a single large grid doesn't overshoot the time limit.
+ */
+
+static int time_up(struct jigsaw *js) {
+	if (__atomic_load_n(&js->timeout, __ATOMIC_RELAXED))
+		return 1;
+	if (!js->opt_timemax || --pollcnt > 0)
+		return 0;
+	pollcnt = POLLSTEP;
+	return out_of_time(js);
+}
+
+/*
+ * Test if the solve must end. Checked between nodes so a round doesn't
+ * overshoot. Errors, the callback and a termination request end the solve
+ * the same way.
+ */
+
+static int deadline(struct jigsaw *js) {
+	if (js->error || js->stop || (js->opt_terminate && *js->opt_terminate))
+		return 1;
+	return out_of_time(js);
+}
+
+/*
+ * Elapsed time for diagnostics
+ */
+
+static char *elapsedstr(struct jigsaw *js) {
+	int secs = (int) elapsed(js);
+
+	sprintf(js->timestr, "%02d:%02d", secs / 60, secs % 60);
+	return js->timestr;
+}
+
+/*
+ * Display the grid. Show disgnostics info in verbose mode
+ */
+
+static void dump_grid(struct jigsaw *js, struct node *d, FILE *f) {
+	int x, y, cnt, attr;
+
+	if (js->opt_debug == 2) {
+		// Double check the number of words
+		cnt = 0;
+		for (x = js->gridsize - 1; x >= 0; x--)
+			if (ISCHAR(d->grid[x])) {
+				if (!ISCHAR(d->grid[x - 1]) && ISCHAR(d->grid[x + 1])) cnt++;
+				if (!ISCHAR(d->grid[x - js->gridxmax]) && ISCHAR(d->grid[x + js->gridxmax])) cnt++;
+			}
+		fprintf(f, "%s seqnr:%d level:%d/%d score:%f numword:%d/%d numchar:%d numconn:%d\n",
+			   elapsedstr(js), d->seqnr, d->firstlevel, d->lastlevel, d->score, d->numword,
+			   cnt, d->numchar, d->numconn);
+	}
+
+	if (js->opt_debug == 2) {
+		// Show grid as I would like to see it
+		for (y = 0; y < js->gridymax; y++) {
+			for (x = 0; x < js->gridxmax; x++) {
+				attr = ATTR(d)[x + y * js->gridxmax] & (TODOH | TODOV);
+				if (attr == (TODOH | TODOV))
+					fprintf(f, "B");
+				else if (attr == TODOH)
+					fprintf(f, "H");
+				else if (attr == TODOV)
+					fprintf(f, "V");
+				else
+					fprintf(f, ".");
+			}
+			fprintf(f, " ");
+			for (x = 0; x < js->gridxmax; x++)
+				if (ISSTAR(d->grid[x + y * js->gridxmax]))
+					fprintf(f, "*");
+				else if (ISFREE(d->grid[x + y * js->gridxmax]))
+					fprintf(f, ".");
+				else if (ISCHAR(d->grid[x + y * js->gridxmax]))
+					fprintf(f, "%c", d->grid[x + y * js->gridxmax] + BASE);
+				else
+					fprintf(f, "0x%02x", d->grid[x + y * js->gridxmax]);
+			fprintf(f, "\n");
+		}
+	} else {
+		// Show grid as Fred would like to see it
+		for (y = 1; y < js->gridymax - 1; y++) {
+			for (x = 1; x < js->gridxmax - 1; x++)
+				if (ISCHAR(d->grid[x + y * js->gridxmax]))
+					fprintf(f, "%c", d->grid[x + y * js->gridxmax] + BASE);
+				else
+					fprintf(f, "-");
+			fprintf(f, "\n");
+		}
+	}
+
+	// For diagnostics
+	fflush(f);
+}
+
+/*
+ * Raise the # words to beat to what the portfolio has found
+ */
+
+static void sync_incumbent(struct jigsaw *js) {
+	int best;
+
+	if (js->opt_incumbent == NULL)
+		return;
+	best = __sync_fetch_and_add(js->opt_incumbent, 0);
+	while (best < js->incumbent && !__sync_bool_compare_and_swap(js->opt_incumbent, best, js->incumbent))
+		best = __sync_fetch_and_add(js->opt_incumbent, 0);
+	if (best > js->incumbent)
+		js->incumbent = best;
+}
+
+/*
+ * Accept an improved solution and hand it to the callback
+ */
+
+static void new_solution(struct jigsaw *js, struct node *d) {
+	memcpy(js->solution, d, js->nodesize);
+	if (d->numword > js->incumbent) {
+		js->incumbent = d->numword;
+		sync_incumbent(js);
+	}
+
+	if (js->callback && js->callback(js, js->arg))
+		js->stop = 1;
+}
+
+/*
+ * Carve a node slot from the current slab. Slabs are aligned and slot sizes
+ * are a multiple of the cache line so nodes never straddle one more than
+ * needed. Slabs are only returned by jigsaw_destroy(), their slots are
+ * recycled through the free lists.
+ */
+
+static struct node *carve_slot(struct jigsaw *js, int size) {
+	void *p;
+
+	if (js->slabfree < size) {
+		if (js->numslab == js->maxslab) {
+			js->maxslab = js->maxslab ? 2 * js->maxslab : 64;
+			js->slabs = (void **) realloc(js->slabs, js->maxslab * sizeof(void *));
+			if (js->slabs == NULL)
+				return NULL;
+		}
+		if (posix_memalign(&p, SLABSIZE, SLABSIZE))
+			return NULL;
+		js->slabs[js->numslab++] = p;
+#ifdef MADV_HUGEPAGE
+		madvise(p, SLABSIZE, MADV_HUGEPAGE);
+#endif
+		js->slabptr = (uint8_t *) p;
+		js->slabfree = SLABSIZE;
+		__sync_fetch_and_add(&js->nummallocbytes, SLABSIZE);
+	}
+	p = js->slabptr;
+	js->slabptr += size;
+	js->slabfree -= size;
+	__sync_fetch_and_add(&js->nummalloc, 1);
+	return (struct node *) p;
+}
+
+/*
+ * Get a stored node of given size, reusing free'ed nodes.
+ * A node that would take memory beyond cap bytes is refused, NULL without error.
+ */
+
+static struct node *mallocnode(struct jigsaw *js, int size, long cap) {
+	struct node *d, **list;
+	long used, peak;
+	int i, pool;
+
+	pool = (size + POOLSTEP - 1) / POOLSTEP;
+	size = pool * POOLSTEP;
+
+	// Charge first, so racing workers can not both slip under the cap
+	used = __sync_add_and_fetch(&js->memused, size);
+	if (cap && used > cap) {
+		__sync_fetch_and_sub(&js->memused, size);
+		return NULL;
+	}
+	while (used > (peak = js->mempeak) && !__sync_bool_compare_and_swap(&js->mempeak, peak, used))
+		;
+
+	if (pool >= POOLMAX) {
+		// Too large to recycle
+		d = (struct node *) malloc(size);
+		__sync_fetch_and_add(&js->nummalloc, 1);
+		__sync_fetch_and_add(&js->nummallocbytes, size);
+	} else if (curworker) {
+		// Refill private free list from the shared one or a slab
+		list = &curworker->freenode[pool];
+		if (*list == NULL) {
+			pthread_mutex_lock(&js->poolmutex);
+			for (i = 0; i < POOLCHUNK; i++) {
+				if ((d = js->freenode[pool]))
+					js->freenode[pool] = d->next;
+				else if ((d = carve_slot(js, size)) == NULL)
+					break;
+				d->next = *list;
+				*list = d;
+			}
+			pthread_mutex_unlock(&js->poolmutex);
+		}
+		if ((d = *list))
+			*list = d->next;
+	} else {
+		// No workers active, shared list is private
+		if ((d = js->freenode[pool]))
+			js->freenode[pool] = d->next;
+		else
+			d = carve_slot(js, size);
+	}
+
+	if (d == NULL) {
+		// Solve ends at the next deadline() test, workers may race here
+		__sync_fetch_and_sub(&js->memused, size);
+		__sync_bool_compare_and_swap(&js->error, 0, JIGSAW_ENOMEM);
+		return NULL;
+	}
+
+	d->pool = pool;
+	return d;
+}
+
+/*
+ * Return a node to the shared free lists
+ */
+
+static void free_node(struct jigsaw *js, struct node *d) {
+	if (d->pool >= POOLMAX) {
+		__sync_fetch_and_sub(&js->memused, d->pool * POOLSTEP);
+		__sync_fetch_and_sub(&js->nummallocbytes, d->pool * POOLSTEP);
+		free(d);
+	} else {
+		__sync_fetch_and_sub(&js->memused, d->pool * POOLSTEP);
+		d->next = js->freenode[d->pool];
+		js->freenode[d->pool] = d;
+	}
+}
+
+/*
+ * Drop a reference to a stored node. Parents go once their last child does.
+ */
+
+static void release_node(struct jigsaw *js, struct node *d) {
+	struct node *parent;
+
+	while (d && --d->refcnt == 0) {
+		parent = d->parent;
+		free_node(js, d);
+		d = parent;
+	}
+}
+
+/*
+ * Replay a placed word onto a full node, the same way place_hword()/place_vword() did.
+ */
+
+static void put_word(struct jigsaw *js, struct node *full, int dir, int xy, int word) {
+	uint8_t *p, *grid, *attr, *tgrid;
+	int step, clr, set;
+
+	if (dir == 'H') {
+		step = 1;
+		clr = TODOH;
+		set = TODOV;
+	} else {
+		step = js->gridxmax;
+		clr = TODOV;
+		set = TODOH;
+	}
+
+	grid = full->grid;
+	attr = ATTR(full);
+	tgrid = TGRID(full);
+	for (p = js->wordbase[word]; *p; xy += step, p++) {
+		if (!ISSTAR(*p)) {
+			attr[xy] &= ~clr;
+			if (ISFREE(grid[xy]))
+				attr[xy] |= set;
+		}
+		grid[xy] = *p;
+		tgrid[js->xy2txy[xy]] = *p;
+	}
+}
+
+/*
+ * Expand a stored node into a full node by replaying its ancestry onto the
+ * empty grid.
+ */
+
+static void expand_node(struct jigsaw *js, struct node *d, struct node *full) {
+	struct node *chain[d->numword], *n;
+	struct adj *m, *mend;
+	int depth;
+
+	memcpy(full, d, NODESIZE(d->numadj));
+	full->parent = d;
+	full->nummark = 0;
+	memcpy(full->grid, js->rootnode->grid, 3 * js->gridsize);
+	memset(WORDS(full), 0, js->wordsetsize);
+
+	for (depth = 0, n = d; n; n = n->parent)
+		chain[depth++] = n;
+
+	while (depth--) {
+		n = chain[depth];
+		for (m = &n->adj[n->numadj], mend = m + n->nummark; m < mend; m++) {
+			if (m->dir == '*')
+				full->grid[m->xy] = TGRID(full)[js->xy2txy[m->xy]] = STAR;
+			else
+				ATTR(full)[m->xy] &= ~(m->dir == 'H' ? TODOH : TODOV);
+		}
+		put_word(js, full, n->dir, n->xy, n->word);
+		BITSET(WORDS(full), n->word);
+	}
+}
+
+/*
+ * Fill the Zobrist keys. A grid's hash is the xor of the keys of all cells
+ * that differ from the empty grid. For symmetrical grids mirrored cells share
+ * their keys, so a grid and its mirror image hash the same.
+ */
+
+static void init_zobrist(struct jigsaw *js) {
+	uint64_t seed, h;
+	int xy, c;
+
+	// splitmix64, fixed seed for reproducable runs
+	seed = 0x6a09e667f3bcc909ULL;
+	for (xy = 0; xy < js->gridsize; xy++) {
+		for (c = 0; c < 32; c++) {
+			if (js->opt_symmetrical && xy > js->gridsize - 1 - xy) {
+				ZOBRIST(xy, c) = ZOBRIST(js->gridsize - 1 - xy, c);
+				continue;
+			}
+			h = (seed += 0x9e3779b97f4a7c15ULL);
+			h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+			ZOBRIST(xy, c) = h ^ (h >> 31);
+		}
+	}
+}
+
+/*
+ * Compare grids. Symmetrical grids also match their mirror image.
+ */
+
+static int same_grid(struct jigsaw *js, uint8_t *a, uint8_t *b) {
+	int xy;
+
+	if (memcmp(a, b, js->gridsize) == 0)
+		return 1;
+	if (!js->opt_symmetrical)
+		return 0;
+	for (xy = 0; xy < js->gridsize; xy++)
+		if (a[xy] != b[js->gridsize - 1 - xy])
+			return 0;
+	return 1;
+}
+
+/*
+ * Double the duplicate detection table. Returns non-zero when out of memory.
+ */
+
+static int grow_hash(struct jigsaw *js) {
+	struct hashent *old;
+	int i, oldsize;
+	uint32_t ix;
+
+	old = js->hashtab;
+	oldsize = js->hashsize;
+	js->hashtab = (struct hashent *) calloc(oldsize ? oldsize * 2 : HASHMIN, sizeof(struct hashent));
+	if (js->hashtab == NULL) {
+		js->hashtab = old;
+		js->error = JIGSAW_ENOMEM;
+		return 1;
+	}
+	js->hashsize = oldsize ? oldsize * 2 : HASHMIN;
+
+	js->hashused = 0;
+	for (i = 0; i < oldsize; i++) {
+		if (old[i].d == NULL || old[i].d == EVICTED)
+			continue;
+		for (ix = old[i].hash & (js->hashsize - 1); js->hashtab[ix].d; ix = (ix + 1) & (js->hashsize - 1))
+			;
+		js->hashtab[ix] = old[i];
+		js->hashused++;
+	}
+	free(old);
+	return 0;
+}
+
+/*
+ * Evaluate grids score, the weighted mean of the evaluators. They only look
+ * at statistics place_hword() and place_vword() keep up to date, so a score
+ * costs a few multiplications. Connections only, the default, has its own
+ * path. With a weight, words count as connections too.
+ */
+
+static float grid_score(struct jigsaw *js, int numword, int numchar, int numconn, int numadj, int lastlevel) {
+	float score = 0, v;
+	int i;
+
+	if (js->numeval == 0)
+		return (numconn + js->opt_weight * numword) / (numchar * (1 + js->opt_weight));
+
+	for (i = 0; i < js->numeval; i++) {
+		switch (js->evalidx[i]) {
+		case JIGSAW_EVAL_CONN:
+			v = (numconn + js->opt_weight * numword) / (numchar * (1 + js->opt_weight));
+			break;
+		case JIGSAW_EVAL_WORD:
+			v = numword < numchar ? (float) numword / numchar : 1;
+			break;
+		case JIGSAW_EVAL_DENSITY:
+			v = numchar < js->levelarea[lastlevel] ? (float) numchar / js->levelarea[lastlevel] : 1;
+			break;
+		case JIGSAW_EVAL_COMPACT:
+			v = 1 - (float) js->levelarea[lastlevel] / js->area;
+			break;
+		default: // JIGSAW_EVAL_ADJ
+			v = 1.0f / (1 + numadj);
+			break;
+		}
+		score += js->evalweight[i] * v;
+	}
+	return score;
+}
+
+static float node_score(struct jigsaw *js, struct node *d) {
+	return grid_score(js, d->numword, d->numchar, d->numconn, d->numadj, d->lastlevel);
+}
+
+/*
+ * Map a score to its bucket in scores[]. Buckets span the range of the
+ * scores of the round, scores beyond go to the first or last bucket.
+ */
+
+static int score_bucket(struct jigsaw *js, float score) {
+	int i;
+
+	i = (int)((score - js->scorelo) * js->scorescale);
+	if (i < 0) i = 0;
+	if (i >= SCOREMAX) i = SCOREMAX - 1;
+	return i;
+}
+
+/*
+ * Lay out the buckets for the round to come from the scores of the grids it
+ * scans. Children score close to their parent, so the buckets span that
+ * range with half of it to spare either side. Finer buckets keep the
+ * frontier cut close to NODEMAX grids. Without a range to go by, like the
+ * start words, the buckets span all scores.
+ */
+
+static void fit_buckets(struct jigsaw *js, float lo, float hi) {
+	if (hi - lo < 0.01f) {
+		js->scorelo = 0;
+		js->scorescale = SCOREMAX - 1;
+		return;
+	}
+	js->scorelo = lo - (hi - lo) / 2;
+	js->scorescale = (SCOREMAX - 1) / (2 * (hi - lo));
+}
+
+/*
+ * Account a generated grid that was rejected by the frontier before it was
+ * stored. Without pairs it still counts against NODEMAX as if it had been.
+ */
+
+static void reject_node(struct jigsaw *js, int numadj) {
+	if (curjob) {
+		curjob->numreject++;
+		curjob->numnode += numadj == 0;
+		curjob->numchild++;
+	} else {
+		js->numreject++;
+		js->numnode += numadj == 0;
+		js->numchild++;
+	}
+}
+
+/*
+ * Raise the cut as long as the buckets above it hold NODEMAX grids without
+ * pairs, dropping those grids from the bucket that falls below the cut.
+ *
+ * Grids with pairs are kept up to PAIRFACTOR times NODEMAX. Their scores are
+ * alike, buckets hold many of them, so once that many are kept a new one
+ * must beat the worst, which is dropped one grid at a time.
+ *
+ * Under a memory cap the grids of the next round get their share of it, the
+ * rest is for the grids of this round and those the scans hold. Over that
+ * share the lowest scoring grids of either kind are dropped, leaving at least
+ * the best bucket without pairs. Beyond the cap new_node() refuses grids.
+ */
+
+static int over_memmax(struct jigsaw *js) {
+	return js->opt_memmax && js->frontiermem > ((long) js->opt_memmax << 20) / MEMSHARE;
+}
+
+static void evict_node(struct jigsaw *js, struct node *d) {
+	struct hashent *h;
+	uint32_t ix;
+
+	// Never match the evicted grid again
+	for (ix = d->hash & (js->hashsize - 1); (h = &js->hashtab[ix])->d != d; ix = (ix + 1) & (js->hashsize - 1))
+		;
+	h->d = EVICTED;
+
+	js->frontiermem -= d->pool * POOLSTEP;
+	release_node(js, d);
+	js->numreject++;
+	js->realnumnode--;
+}
+
+static int pair_cut(struct jigsaw *js) {
+	// Lowest bucket holding grids with pairs, there must be one
+	while (js->bucketcnt[1][js->cutbucket[1]] == 0)
+		js->cutbucket[1]++;
+	return js->cutbucket[1];
+}
+
+static int pairs_full(struct jigsaw *js) {
+	if (js->numfrontier[1] < PAIRFACTOR * js->nodemax)
+		return 0;
+	pair_cut(js);
+	return 1;
+}
+
+static void drop_pair(struct jigsaw *js) {
+	struct node *d, **prev;
+	int i;
+
+	i = pair_cut(js);
+	for (prev = &js->scores[i]; (*prev)->numadj == 0; prev = &(*prev)->next)
+		;
+	d = *prev;
+	*prev = d->next;
+	if (js->scoretail[i] == &d->next)
+		js->scoretail[i] = prev;
+	js->bucketcnt[1][i]--;
+	js->numfrontier[1]--;
+	evict_node(js, d);
+}
+
+static void raise_cut(struct jigsaw *js) {
+	struct node *d, **prev;
+	int above;
+
+	while (js->cutbucket[0] < SCOREMAX - 1) {
+		above = js->numfrontier[0] - js->bucketcnt[0][js->cutbucket[0]];
+		if (above < js->nodemax) {
+			if (!over_memmax(js))
+				break;
+			if (js->numfrontier[1] > 0 && (above == 0 || pair_cut(js) <= js->cutbucket[0])) {
+				drop_pair(js);
+				continue;
+			}
+			if (above == 0)
+				break;
+		}
+		js->numfrontier[0] -= js->bucketcnt[0][js->cutbucket[0]];
+		js->scoretail[js->cutbucket[0]] = &js->scores[js->cutbucket[0]];
+		for (prev = &js->scores[js->cutbucket[0]]; (d = *prev); ) {
+			if (d->numadj > 0) {
+				prev = js->scoretail[js->cutbucket[0]] = &d->next;
+				continue;
+			}
+			*prev = d->next;
+			evict_node(js, d);
+		}
+		js->cutbucket[0]++;
+	}
+}
+
+/*
+ * Upper bound of the number of words a grid can end up with. New words need
+ * room for their characters: two per free cell, one per character that is
+ * not yet part of a crossing. Without pairs, characters next to each other
+ * share a word already, so a new word can't take two in a row and half its
+ * characters go on free cells. Only the unused words are left to place.
+ */
+
+static int max_words(struct jigsaw *js, struct node *d) {
+	int more;
+
+	more = js->maxmore[2 * d->numfree + d->numchar - d->numconn];
+	if (d->numadj == 0 && more > js->maxhalf[2 * d->numfree])
+		more = js->maxhalf[2 * d->numfree];
+	if (more > js->numword - d->numword)
+		more = js->numword - d->numword;
+	return d->numword + more;
+}
+
+static void add_node(struct jigsaw *js, struct node *d) {
+	int i, expanded = 0;
+	struct hashent *h;
+	uint32_t ix;
+
+	// Drop grids that can't beat the solution, or the portfolio's best
+	if (max_words(js, d) <= js->incumbent) {
+		js->numprune++;
+		release_node(js, d);
+		return;
+	}
+
+	// Score was set when the word was placed
+	i = score_bucket(js, d->score);
+
+	// Workers may have tested against an older cut. With pairs, once the
+	// frontier of those is full, it must beat the worst kept
+	if (i < js->cutbucket[d->numadj > 0] || (d->numadj > 0 && pairs_full(js) && i <= js->cutbucket[1])) {
+		js->numreject++;
+		js->numnode += d->numadj == 0;
+		release_node(js, d);
+		return;
+	}
+
+	// Test if entry is duplicate
+	if (2 * (js->hashused + 1) > js->hashsize && grow_hash(js)) {
+		release_node(js, d);
+		return;
+	}
+	for (ix = d->hash & (js->hashsize - 1); js->hashtab[ix].d; ix = (ix + 1) & (js->hashsize - 1)) {
+		h = &js->hashtab[ix];
+		if (h->d == EVICTED || h->hash != d->hash || h->stats != HASHSTATS(d))
+			continue;
+		js->hashtst++;
+		if (!expanded++)
+			expand_node(js, d, js->cmpnode[0]);
+		expand_node(js, h->d, js->cmpnode[1]);
+		if (same_grid(js, js->cmpnode[0]->grid, js->cmpnode[1]->grid)) {
+			js->numdup++;
+			release_node(js, d);
+			return;
+		}
+		js->hashhit++;
+	}
+	js->hashtab[ix].hash = d->hash;
+	js->hashtab[ix].stats = HASHSTATS(d);
+	js->hashtab[ix].d = d;
+	js->hashused++;
+
+	// Diagnostics
+	if (js->opt_dump > 1) {
+		expand_node(js, d, js->cmpnode[0]);
+		dump_grid(js, js->cmpnode[0], stdout);
+	}
+
+	// Enter grid into its score bucket, sorted when the round ends
+	d->seqnr = js->seqnr++;
+	d->next = NULL;
+	*js->scoretail[i] = d;
+	js->scoretail[i] = &d->next;
+	js->frontiermem += d->pool * POOLSTEP;
+	if (d->numadj == 0) {
+		js->numnode++;
+		js->bucketcnt[0][i]++;
+		js->numfrontier[0]++;
+	} else {
+		js->bucketcnt[1][i]++;
+		if (++js->numfrontier[1] > PAIRFACTOR * js->nodemax)
+			drop_pair(js);
+	}
+	js->realnumnode++;
+	raise_cut(js);
+}
+
+/*
+ * Sort a list on descending score and hash, like the lists used to be kept
+ * while inserting. The sort is stable.
+ */
+
+static struct node *sort_nodes(struct node *list) {
+	struct node *a, *b, **tail, *mid;
+
+	if (list == NULL || list->next == NULL)
+		return list;
+
+	// Split in halves
+	for (a = list, mid = list->next; mid && mid->next; mid = mid->next->next)
+		a = a->next;
+	b = a->next;
+	a->next = NULL;
+	a = sort_nodes(list);
+	b = sort_nodes(b);
+
+	// Merge
+	for (tail = &list; a && b; tail = &(*tail)->next) {
+		if (b->score > a->score || (b->score == a->score && b->hash > a->hash)) {
+			*tail = b;
+			b = b->next;
+		} else {
+			*tail = a;
+			a = a->next;
+		}
+	}
+	*tail = a ? a : b;
+	return list;
+}
+
+/*
+ * Hand over a new grid. Workers collect them for their current job,
+ * they are added to scores[] when the batch is merged.
+ */
+
+static void save_node(struct jigsaw *js, struct node *d) {
+	if (curjob) {
+		d->next = NULL;
+		*curjob->childtail = d;
+		curjob->childtail = &d->next;
+		curjob->numchild++;
+	} else {
+		js->numchild++;
+		add_node(js, d);
+	}
+}
+
+
+/*
+ * Test a word against a line of the grid, a row or a column of the transposed
+ * grid, with prev/next the neighbouring lines. Returns 0 on a conflict,
+ * otherwise adjmask has a bit set for each new character that would be
+ * adjacent to an existing character across the line. Lines are read whole
+ * words at a time, full nodes have room for that past their end.
+ */
+
+static int fit_word(struct jigsaw *js, uint8_t *line, uint8_t *prev, uint8_t *next, int word, uint64_t *adjmask) {
+	uint64_t len, bad, mask;
+#ifdef __SSE2__
+	__m128i g, w, free, newc, nb;
+	int i;
+
+	bad = mask = 0;
+	for (i = 0; i < js->wlen[word]; i += 16) {
+		g = _mm_loadu_si128((__m128i *) (line + i));
+		w = _mm_loadu_si128((__m128i *) (js->wordbase[word] + i));
+		free = _mm_cmpeq_epi8(g, _mm_set1_epi8(FREE));
+		bad |= (uint64_t) (~_mm_movemask_epi8(_mm_or_si128(free, _mm_cmpeq_epi8(g, w))) & 0xffff) << i;
+		newc = _mm_andnot_si128(_mm_cmpeq_epi8(w, _mm_set1_epi8(STAR)), free);
+		nb = _mm_or_si128(_mm_cmplt_epi8(_mm_loadu_si128((__m128i *) (prev + i)), _mm_set1_epi8(STAR)),
+				  _mm_cmplt_epi8(_mm_loadu_si128((__m128i *) (next + i)), _mm_set1_epi8(STAR)));
+		mask |= (uint64_t) _mm_movemask_epi8(_mm_and_si128(newc, nb)) << i;
+	}
+#else
+	uint8_t *p;
+	int i;
+
+	bad = mask = 0;
+	for (i = 0, p = js->wordbase[word]; *p; i++, p++) {
+		if (line[i] == *p)
+			continue; // Char already there
+		if (!ISFREE(line[i]))
+			bad |= (uint64_t) 1 << i; // Char placement conflict
+		else if (!ISSTAR(*p) && (ISCHAR(prev[i]) || ISCHAR(next[i])))
+			mask |= (uint64_t) 1 << i; // Adjacent chars
+	}
+#endif
+
+	len = js->wlen[word] < 64 ? ((uint64_t) 1 << js->wlen[word]) - 1 : ~(uint64_t) 0;
+	if (bad & len)
+		return 0;
+	*adjmask = mask & len;
+	return 1;
+}
+
+/*
+ * The next two routines test if a given word can be placed in the grid.
+ * If a new character will be adjacent to an existing character, check
+ * if the newly formed character pair exist in the wordlist (it doesn't
+ * matter where).
+ */
+
+static int test_hword(struct jigsaw *js, struct node *d, int xybase, int word) {
+	uint8_t *p, *grid;
+	uint64_t adjmask;
+	int i, l;
+
+	// Some basic tests
+	if (xybase < 0 || xybase + js->wlen[word] >= js->gridsize)
+		return 0;
+
+	if (js->opt_symmetrical) {
+		// How about star's
+		if (ISCHAR(d->grid[js->gridsize - 1 - xybase]))
+			return 0;
+		if (ISCHAR(d->grid[js->gridsize - 1 - (xybase + js->wlen[word] - 1)]))
+			return 0;
+	}
+
+	// Will new characters create conflicts
+	grid = d->grid + xybase;
+	if (!fit_word(js, grid, grid - js->gridxmax, grid + js->gridxmax, word, &adjmask))
+		return 0;
+	for (; adjmask; adjmask &= adjmask - 1) {
+		i = __builtin_ctzll(adjmask);
+		grid = d->grid + xybase + i;
+		p = js->wordbase[word] + i;
+
+		if (!ISCHAR(grid[-js->gridxmax]))
+			l = js->links2[*p][grid[+js->gridxmax]];
+		else if (!ISCHAR(grid[+js->gridxmax]))
+			l = js->links2[grid[-js->gridxmax]][*p];
+		else
+			l = js->links3[grid[-js->gridxmax]][*p][grid[+js->gridxmax]];
+		if (l == 0)
+			return 0;
+	}
+
+	// Word can be placed
+	return 1;
+}
+
+static int test_vword(struct jigsaw *js, struct node *d, int xybase, int word) {
+	uint8_t *p, *grid;
+	uint64_t adjmask;
+	int i, l;
+
+	// Some basic tests
+	if (xybase < 0 || xybase + js->wlen[word] * js->gridxmax >= js->gridsize)
+		return 0;
+
+	if (js->opt_symmetrical) {
+		// How about star's
+		if (ISCHAR(d->grid[js->gridsize - 1 - xybase]))
+			return 0;
+		if (ISCHAR(d->grid[js->gridsize - 1 - (xybase + js->wlen[word] * js->gridxmax - js->gridxmax)]))
+			return 0;
+	}
+
+	// Will new characters create conflicts
+	grid = TGRID(d) + js->xy2txy[xybase];
+	if (!fit_word(js, grid, grid - js->gridymax, grid + js->gridymax, word, &adjmask))
+		return 0;
+	for (; adjmask; adjmask &= adjmask - 1) {
+		i = __builtin_ctzll(adjmask);
+		grid = d->grid + xybase + i * js->gridxmax;
+		p = js->wordbase[word] + i;
+
+		if (!ISCHAR(grid[-1]))
+			l = js->links2[*p][grid[+1]];
+		else if (!ISCHAR(grid[+1]))
+			l = js->links2[grid[-1]][*p];
+		else
+			l = js->links3[grid[-1]][*p][grid[+1]];
+		if (l == 0)
+			return 0;
+	}
+
+	// Word can be placed
+	return 1;
+}
+
+
+/*
+ * Dead regions. Words must cross a character, so a region of free cells that
+ * borders no character can never get one. Only a new star can close off a
+ * region, and new stars always border a character, so a closed region was
+ * open before and is counted once. Its cells are taken from numfree, making
+ * max_words() exact about them. Cells are marked while filling and restored
+ * after, the fill stops at the first character it borders.
+ */
+
+static int fill_region(struct jigsaw *js, uint8_t *grid, int16_t *fill, int *numfill, int xy) {
+	int dirs[4] = { 1, -1, js->gridxmax, -js->gridxmax };
+	int j, k, c, n, first, open = 0;
+
+	if (!ISFREE(grid[xy]))
+		return 0; // Filled already
+	first = *numfill;
+	grid[fill[(*numfill)++] = xy] = CUTOFF;
+	for (j = first; j < *numfill && !open; j++) {
+		c = fill[j];
+		for (k = 0; k < 4; k++) {
+			n = c + dirs[k];
+			if (ISCHAR(grid[n]) || grid[n] == REACHED)
+				open = 1;
+			else if (ISFREE(grid[n]))
+				grid[fill[(*numfill)++] = n] = CUTOFF;
+		}
+	}
+	if (!open)
+		return *numfill - first;
+	for (j = first; j < *numfill; j++)
+		grid[fill[j]] = REACHED;
+	return 0;
+}
+
+/*
+ * Regions next to a new star. The star borders a character, a free cell on
+ * either side of it is open when the cell next to it beside the character is
+ * not a star, the cell ahead when the cell next to it beside an open side is
+ * not. What remains is filled.
+ */
+
+static int fill_star(struct jigsaw *js, uint8_t *grid, int16_t *fill, int *numfill, int xy) {
+	int dirs[4] = { 1, -1, js->gridxmax, -js->gridxmax };
+	int i, n, back, side, dead = 0;
+
+	for (i = 0; i < 4 && !ISCHAR(grid[xy + dirs[i]]); i++)
+		;
+	if (i == 4) {
+		for (i = 0; i < 4; i++)
+			dead += fill_region(js, grid, fill, numfill, xy + dirs[i]);
+		return dead;
+	}
+
+	back = dirs[i];
+	side = back == 1 || back == -1 ? js->gridxmax : 1;
+	for (n = xy - side; n <= xy + side; n += 2 * side) {
+		if (ISFREE(grid[n]) && !ISSTAR(grid[n + back]))
+			grid[fill[(*numfill)++] = n] = REACHED;
+		else
+			dead += fill_region(js, grid, fill, numfill, n);
+	}
+
+	// Likewise the cell ahead when next to an open side
+	n = xy - back;
+	if (ISFREE(grid[n]) && ((grid[xy - side] == REACHED && !ISSTAR(grid[n - side])) ||
+	    (grid[xy + side] == REACHED && !ISSTAR(grid[n + side]))))
+		grid[fill[(*numfill)++] = n] = REACHED;
+	else
+		dead += fill_region(js, grid, fill, numfill, n);
+	return dead;
+}
+
+/*
+ * # free cells closed off by placing a word on a full node, its delimiters
+ * are the new stars
+ */
+
+static int cut_off(struct jigsaw *js, struct node *full, int xybase, int step, int word) {
+	uint8_t save[WORDLENMAX], *grid = full->grid;
+	int i, len, end, head, tail, numfill = 0, dead = 0;
+
+	len = js->wlen[word];
+	end = xybase + (len - 1) * step;
+	head = ISFREE(grid[xybase]);
+	tail = ISFREE(grid[end]);
+	if (js->opt_symmetrical || (!head && !tail))
+		return 0;
+
+	for (i = 0; i < len; i++) {
+		save[i] = grid[xybase + i * step];
+		grid[xybase + i * step] = js->wordbase[word][i];
+	}
+	if (head)
+		dead += fill_star(js, grid, FILL(full), &numfill, xybase);
+	if (tail)
+		dead += fill_star(js, grid, FILL(full), &numfill, end);
+	while (numfill)
+		grid[FILL(full)[--numfill]] = FREE;
+	for (i = 0; i < len; i++)
+		grid[xybase + i * step] = save[i];
+	return dead;
+}
+
+/*
+ * Create a stored child of a full node with room for numadj pairs and the
+ * marks made so far. Returns NULL when out of memory, or without error when
+ * the child would not fit under the memory cap.
+ */
+
+static struct node *new_node(struct jigsaw *js, struct node *data, int numadj) {
+	struct node *d;
+	int pool;
+
+	d = mallocnode(js, NODESIZE(numadj + data->nummark), (long) js->opt_memmax << 20);
+	if (d == NULL)
+		return NULL;
+	pool = d->pool;
+	memcpy(d, data, NODESIZE(numadj));
+	d->pool = pool;
+	d->refcnt = 1;
+	if (d->parent)
+		d->parent->refcnt++;
+	return d;
+}
+
+/*
+ * # pairs left once a word is placed, those it completes are gone.
+ */
+
+static int left_pairs(struct jigsaw *js, struct node *data, int numadj, int dir, int xybase, int step, int word) {
+	uint8_t *p;
+	int i, xy;
+
+	for (xy = xybase, p = js->wordbase[word]; *p; xy += step, p++) {
+		if (ISSTAR(*p))
+			continue;
+		for (i = 0; i < data->numadj; i++)
+			if (data->adj[i].dir == dir && data->adj[i].xy == xy) {
+				numadj--;
+				break;
+			}
+	}
+	return numadj;
+}
+
+/*
+ * Test if placing a word would create a grid that scores below the frontier
+ * cut of grids with or without pairs. Such grids are never scanned so don't
+ * bother storing them, they are accounted as rejected right away.
+ */
+
+static int below_cut(struct jigsaw *js, struct node *data, int numadj, int dir, int xybase, int step, int word) {
+	uint8_t *p, *grid;
+	int i, xy, numchar, numconn, lastlevel;
+
+	if (js->cutbucket[0] == 0 && js->cutbucket[1] == 0) return 0;
+
+	numchar = data->numchar;
+	numconn = data->numconn;
+	lastlevel = data->lastlevel;
+	for (xy = xybase, grid = data->grid + xy, p = js->wordbase[word]; *p; grid += step, xy += step, p++) {
+		if (ISSTAR(*p))
+			continue;
+		if (ISFREE(*grid))
+			numchar++;
+		else
+			numconn++;
+		for (i = 0; i < data->numadj; i++)
+			if (data->adj[i].dir == dir && data->adj[i].xy == xy) {
+				numadj--;
+				break;
+			}
+	}
+	if (js->cutbucket[numadj > 0] == 0) return 0;
+
+	if (js->xy2level[xy - step] > lastlevel)
+		lastlevel = js->xy2level[xy - step];
+
+	if (score_bucket(js, grid_score(js, data->numword + 1, numchar, numconn, numadj, lastlevel)) >= js->cutbucket[numadj > 0])
+		return 0;
+	reject_node(js, numadj);
+	return 1;
+}
+
+/*
+ * The next two routines will place a given word in the grid. These routines
+ * also performs several sanity checks to make sure the new grid is worth
+ * it to continue with. If a newly placed character is adjacent to an
+ * existing character, then that pair must be part of a word that can
+ * be physically placed. If multiple character pairs exist, then no check
+ * is done to determine if those words (of which the pairs are part) can
+ * be adjacent. That is done later as these grids are not counted against
+ * NODEMAX.
+ */
+
+static int place_hword(struct jigsaw *js, struct node *data, int xybase, int word) {
+	struct node *d = data;
+	uint8_t *p, *grid;
+	uint64_t adjmask;
+	int i, l, xy;
+	int newnumadj;
+	struct link *ld;
+
+	// Can word be placed
+	if (INSET(WORDS(d), word)) return 0;
+	if (xybase < 0 || xybase + js->wlen[word] >= js->gridsize + 1) return 0;
+
+	if (js->opt_symmetrical) {
+		// How about star's
+		if (ISCHAR(d->grid[js->gridsize - 1 - xybase]))
+			return 0;
+		if (ISCHAR(d->grid[js->gridsize - 1 - (xybase + js->wlen[word] - 1)]))
+			return 0;
+	}
+
+	// check character environment
+	grid = d->grid + xybase;
+	if (!fit_word(js, grid, grid - js->gridxmax, grid + js->gridxmax, word, &adjmask))
+		return 0;
+	newnumadj = d->numadj;
+	for (; adjmask; adjmask &= adjmask - 1) {
+		i = __builtin_ctzll(adjmask);
+		xy = xybase + i;
+		grid = d->grid + xy;
+		p = js->wordbase[word] + i;
+
+		if (ISFREE(grid[-js->gridxmax])) {
+			d->adj[newnumadj].xy = xy;
+			d->adj[newnumadj].l = js->links2[*p][grid[+js->gridxmax]];
+		} else if (ISFREE(grid[+js->gridxmax])) {
+			d->adj[newnumadj].xy = xy - js->gridxmax;
+			d->adj[newnumadj].l = js->links2[grid[-js->gridxmax]][*p];
+		} else {
+			d->adj[newnumadj].xy = xy - js->gridxmax;
+			d->adj[newnumadj].l = js->links3[grid[-js->gridxmax]][*p][grid[+js->gridxmax]];
+		}
+		if (d->adj[newnumadj].l == 0 || newnumadj == ADJMAX - 1)
+			return 0;
+		d->adj[newnumadj++].dir = 'V';
+	}
+
+	// Test if new adj's really exist
+	for (i = d->numadj; i < newnumadj; i++) {
+		for (l = d->adj[i].l; l; l = ld->next) {
+			ld = &js->linkdat[l];
+			if (test_vword(js, d, d->adj[i].xy + ld->ofs * js->gridxmax, ld->w))
+				break;
+		}
+		if (l == 0) return 0;
+		d->adj[i].l = l;
+	}
+
+	// Don't store what the next round will not look at
+	if (below_cut(js, data, newnumadj, 'H', xybase, 1, word))
+		return 1;
+
+	// Get a new node, only the placed word is stored
+	d = new_node(js, data, newnumadj);
+	if (d == NULL) {
+		if (js->error)
+			return 0;
+
+		// No room under the memory cap, rejected as if below the cut
+		reject_node(js, left_pairs(js, data, newnumadj, 'H', xybase, 1, word));
+		return 1;
+	}
+
+	// Place word
+	d->numword++;
+	d->numadj = newnumadj;
+	d->dir = 'H';
+	d->xy = xybase;
+	d->word = word;
+	for (xy = xybase, grid = data->grid + xy, p = js->wordbase[word]; *p; grid++, xy++, p++) {
+		if (ISFREE(*grid)) {
+			d->hash ^= ZOBRIST(xy, *p);
+			d->numfree--;
+		}
+		if (!ISSTAR(*p)) {
+
+			// Remove character pair hints that are part of the new word
+			for (i = 0; i < d->numadj; i++)
+				if (d->adj[i].dir == 'H' && d->adj[i].xy == xy) {
+					d->adj[i] = d->adj[--d->numadj];
+					break; // There can be only one
+				}
+
+			// Count character
+			if (ISFREE(*grid))
+				d->numchar++;
+			else
+				d->numconn++;
+		}
+	}
+
+	// Inherit the marks of the scan so far
+	memcpy(&d->adj[d->numadj], MARKS(data), data->nummark * sizeof(struct adj));
+	d->nummark = data->nummark;
+
+	// Update hotspot
+	if (js->xy2level[xy - 1] > d->lastlevel)
+		d->lastlevel = js->xy2level[xy - 1];
+
+	// Regions the word closes off
+	d->numfree -= cut_off(js, data, xybase, 1, word);
+
+	// Score from the statistics kept above
+	d->score = node_score(js, d);
+
+	if (js->opt_symmetrical) {
+		// Don't forget the symmetry, a word across the middle is its own mirror image
+		if (d->symdir == 0) {
+			d->symxy = js->gridsize - 1 - (xybase + js->wlen[word] - 1);
+			d->symlen = js->wlen[word];
+			if (d->symxy != xybase)
+				d->symdir = 'H';
+		} else
+			d->symdir = 0;
+	}
+
+	// Save grid
+	save_node(js, d);
+	return 1;
+}
+
+static int place_vword(struct jigsaw *js, struct node *data, int xybase, int word) {
+	struct node *d = data;
+	uint8_t *p, *grid;
+	uint64_t adjmask;
+	int i, xy, l;
+	int newnumadj;
+	struct link *ld;
+
+	// Some basic tests
+	if (INSET(WORDS(d), word)) return 0;
+	if (xybase < 0 || xybase + js->wlen[word] * js->gridxmax >= js->gridsize + js->gridxmax) return 0;
+
+	if (js->opt_symmetrical) {
+		// How about star's
+		if (ISCHAR(d->grid[js->gridsize - 1 - xybase]))
+			return 0;
+		if (ISCHAR(d->grid[js->gridsize - 1 - (xybase + js->wlen[word] * js->gridxmax - js->gridxmax)]))
+			return 0;
+	}
+
+	// Check character environment
+	grid = TGRID(d) + js->xy2txy[xybase];
+	if (!fit_word(js, grid, grid - js->gridymax, grid + js->gridymax, word, &adjmask))
+		return 0;
+	newnumadj = d->numadj;
+	for (; adjmask; adjmask &= adjmask - 1) {
+		i = __builtin_ctzll(adjmask);
+		xy = xybase + i * js->gridxmax;
+		grid = d->grid + xy;
+		p = js->wordbase[word] + i;
+
+		if (ISFREE(grid[-1])) {
+			d->adj[newnumadj].xy = xy;
+			d->adj[newnumadj].l = js->links2[*p][grid[+1]];
+		} else if (ISFREE(grid[+1])) {
+			d->adj[newnumadj].xy = xy - 1;
+			d->adj[newnumadj].l = js->links2[grid[-1]][*p];
+		} else {
+			d->adj[newnumadj].xy = xy - 1;
+			d->adj[newnumadj].l = js->links3[grid[-1]][*p][grid[+1]];
+		}
+		if (d->adj[newnumadj].l == 0 || newnumadj == ADJMAX - 1)
+			return 0;
+		d->adj[newnumadj++].dir = 'H';
+	}
+
+	// Test if new adj's really exist
+	for (i = d->numadj; i < newnumadj; i++) {
+		for (l = d->adj[i].l; l; l = ld->next) {
+			ld = &js->linkdat[l];
+			if (test_hword(js, d, d->adj[i].xy + ld->ofs, ld->w))
+				break;
+		}
+		if (l == 0) return 0;
+		d->adj[i].l = l;
+	}
+
+	// Don't store what the next round will not look at
+	if (below_cut(js, data, newnumadj, 'V', xybase, js->gridxmax, word))
+		return 1;
+
+	// Get a new node, only the placed word is stored
+	d = new_node(js, data, newnumadj);
+	if (d == NULL) {
+		if (js->error)
+			return 0;
+
+		// No room under the memory cap, rejected as if below the cut
+		reject_node(js, left_pairs(js, data, newnumadj, 'V', xybase, js->gridxmax, word));
+		return 1;
+	}
+
+	// Place word
+	d->numword++;
+	d->numadj = newnumadj;
+	d->dir = 'V';
+	d->xy = xybase;
+	d->word = word;
+	for (xy = xybase, grid = data->grid + xy, p = js->wordbase[word]; *p; grid += js->gridxmax, xy += js->gridxmax, p++) {
+		if (ISFREE(*grid)) {
+			d->hash ^= ZOBRIST(xy, *p);
+			d->numfree--;
+		}
+		if (!ISSTAR(*p)) {
+
+			// Remove character pair hints that are part of the new word
+			for (i = 0; i < d->numadj; i++)
+				if (d->adj[i].dir == 'V' && d->adj[i].xy == xy) {
+					d->adj[i] = d->adj[--d->numadj];
+					break; // There can be only one
+				}
+
+			// Count character
+			if (ISFREE(*grid))
+				d->numchar++;
+			else
+				d->numconn++;
+		}
+	}
+
+	// Inherit the marks of the scan so far
+	memcpy(&d->adj[d->numadj], MARKS(data), data->nummark * sizeof(struct adj));
+	d->nummark = data->nummark;
+
+	// Update hotspot
+	if (js->xy2level[xy - js->gridxmax] > d->lastlevel)
+		d->lastlevel = js->xy2level[xy - js->gridxmax];
+
+	// Regions the word closes off
+	d->numfree -= cut_off(js, data, xybase, js->gridxmax, word);
+
+	// Score from the statistics kept above
+	d->score = node_score(js, d);
+
+	if (js->opt_symmetrical) {
+		// Don't forget the symmetry, a word across the middle is its own mirror image
+		if (d->symdir == 0) {
+			d->symxy = js->gridsize - 1 - (xybase + js->wlen[word] * js->gridxmax - js->gridxmax);
+			d->symlen = js->wlen[word];
+			if (d->symxy != xybase)
+				d->symdir = 'V';
+		} else
+			d->symdir = 0;
+	}
+
+	// Save grid
+	save_node(js, d);
+	return 1;
+}
+
+
+/*
+ * Change a cell of a full node while scanning it. The changes are recorded as
+ * they are part of the grids placed afterwards.
+ */
+
+static void mark_grid(struct jigsaw *js, struct node *d, int xy, int op) {
+	struct adj *m;
+	int numfill = 0;
+
+	if (op == '*') {
+		if (ISSTAR(d->grid[xy]))
+			return;
+		if (!ISFREE(d->grid[xy]))
+			d->hash ^= ZOBRIST(xy, d->grid[xy]);
+		else
+			d->numfree--;
+		d->hash ^= ZOBRIST(xy, STAR);
+		d->grid[xy] = TGRID(d)[js->xy2txy[xy]] = STAR;
+
+		// Regions the star closes off
+		if (!js->opt_symmetrical) {
+			d->numfree -= fill_star(js, d->grid, FILL(d), &numfill, xy);
+			while (numfill)
+				d->grid[FILL(d)[--numfill]] = FREE;
+		}
+	} else {
+		ATTR(d)[xy] &= ~(op == 'H' ? TODOH : TODOV);
+	}
+
+	m = &MARKS(d)[d->nummark++];
+	m->xy = xy;
+	m->l = 0;
+	m->dir = op;
+}
+
+/*
+ * Characters that can be placed on a cell by a word in the other direction,
+ * pstep is the step across that word. Free cells take any character that
+ * forms known pairs with their neighbours.
+ */
+
+static uint32_t cell_mask(struct jigsaw *js, struct node *d, int xy, int pstep) {
+	if (!ISFREE(d->grid[xy]))
+		return 1u << d->grid[xy];
+	return js->fitmask[d->grid[xy - pstep]][d->grid[xy + pstep]];
+}
+
+/*
+ * Scan a grid while improving a solution. Words may cross any character that
+ * is not crossed yet, there is no hotspot to sweep and no cell is given up.
+ */
+
+static void scan_cross(struct jigsaw *js, struct node *d) {
+	uint8_t *grid, *attr;
+	int xy, l, tstxy;
+	struct link *ld;
+	uint32_t before, after;
+
+	for (xy = js->gridxmax + 1, grid = d->grid + xy, attr = ATTR(d) + xy;
+	     xy < js->gridsize - js->gridxmax - 1;
+	     xy++, grid++, attr++) {
+		if (!ISCHAR(*grid))
+			continue;
+		if (time_up(js))
+			return;
+
+		if (*attr & TODOH) {
+			before = cell_mask(js, d, xy - 1, js->gridxmax);
+			after = cell_mask(js, d, xy + 1, js->gridxmax);
+			for (l = js->links1[*grid]; l; l = ld->next) {
+				ld = &js->linkdat[l];
+				if (INSET(WORDS(d), ld->w) || !(before >> ld->prev & after >> ld->post & 1))
+					continue; // Does not fit around xy
+				place_hword(js, d, xy + ld->ofs, ld->w);
+			}
+		}
+		if (*attr & TODOV) {
+			before = cell_mask(js, d, xy - js->gridxmax, 1);
+			after = cell_mask(js, d, xy + js->gridxmax, 1);
+			for (l = js->links1[*grid]; l; l = ld->next) {
+				ld = &js->linkdat[l];
+				if (INSET(WORDS(d), ld->w) || !(before >> ld->prev & after >> ld->post & 1))
+					continue; // Does not fit around xy
+				tstxy = xy + ld->ofs * js->gridxmax;
+				if (tstxy >= 0)
+					place_vword(js, d, tstxy, ld->w);
+			}
+		}
+	}
+}
+
+/*
+ * Scan a grid and place a word. To supress an exponential growth of
+ * generated grids, we can be very fussy when chosing which word to
+ * place. I have chosen to fill the grid from top-left to bottom-right
+ * making sure the newly placed words fit tightly to the already placed
+ * words. If this is not possible, then I choose just one word such that
+ * the first letter is nearest to the start of the hotspot regeon.
+ * This sounds easy but it took me quite some time to figure it out.
+ */
+
+static void scan_grid(struct jigsaw *js, struct node *d) {
+	uint8_t *grid, *attr;
+	int xy, l, cnt, tstxy, level, w;
+	struct link *ld;
+	int hasplace, hasfree;
+	uint32_t before, after;
+
+	if (js->opt_symmetrical) {
+		// Don't forget the symmetry
+		if (d->symdir == 'H') {
+			for (w = js->numword - 1; w >= 0 && !time_up(js); w--)
+				if (!INSET(WORDS(d), w) && js->wlen[w] == d->symlen)
+					place_hword(js, d, d->symxy, w);
+			return;
+		}
+		if (d->symdir == 'V') {
+			for (w = js->numword - 1; w >= 0 && !time_up(js); w--)
+				if (!INSET(WORDS(d), w) && js->wlen[w] == d->symlen)
+					place_vword(js, d, d->symxy, w);
+			return;
+		}
+	}
+
+	// locate unaccounted adjacent cells
+	if (d->numadj > 0) {
+		xy = d->adj[--d->numadj].xy;
+		if (d->adj[d->numadj].dir == 'H') {
+			for (l = d->adj[d->numadj].l; l; l = ld->next) {
+				ld = &js->linkdat[l];
+				place_hword(js, d, xy + ld->ofs, ld->w);
+			}
+		} else {
+			for (l = d->adj[d->numadj].l; l; l = ld->next) {
+				ld = &js->linkdat[l];
+				place_vword(js, d, xy + ld->ofs * js->gridxmax, ld->w);
+			}
+		}
+		return;
+	}
+
+	// Nominate grid for final result
+	if (d->numword > js->solution->numword) {
+		if (curjob) {
+			// Solution is updated when the batch is merged
+			if (curjob->best == NULL)
+				curjob->best = (struct node *) malloc(js->nodesize);
+			if (curjob->best == NULL) {
+				__sync_bool_compare_and_swap(&js->error, 0, JIGSAW_ENOMEM);
+				return;
+			}
+			memcpy(curjob->best, d, js->nodesize);
+		} else
+			new_solution(js, d);
+	}
+
+	if (js->improving) {
+		scan_cross(js, d);
+		return;
+	}
+
+	// Sweep grid from top-left to bottom-right corner
+	for (level = d->firstlevel; level <= d->lastlevel && level <= js->gridxmax + js->gridymax - 4; level++) {
+		if (time_up(js))
+			return; // The grid is abandoned with the solve
+
+		if (!js->opt_symmetrical) {
+			// Locate 'tight' words
+			hasplace = 0;
+			for (xy = js->level2xy[level], grid = d->grid + xy, attr = ATTR(d) + xy;
+			     !ISBORDER(*attr);
+			     xy += js->gridxmax - 1, grid += js->gridxmax - 1, attr += js->gridxmax - 1) {
+				if (*attr & TODOH) {
+					before = cell_mask(js, d, xy - 1, js->gridxmax);
+					after = cell_mask(js, d, xy + 1, js->gridxmax);
+					for (l = js->links1[*grid]; l; l = ld->next) {
+						ld = &js->linkdat[l];
+						if (INSET(WORDS(d), ld->w) || !(before >> ld->prev & after >> ld->post & 1))
+							continue; // Does not fit around xy
+						tstxy = xy + ld->ofs;
+						if (tstxy >= 0 && js->xy2level[tstxy] == d->firstlevel)
+							hasplace += place_hword(js, d, tstxy, ld->w);
+					}
+				}
+				if (*attr & TODOV) {
+					before = cell_mask(js, d, xy - js->gridxmax, 1);
+					after = cell_mask(js, d, xy + js->gridxmax, 1);
+					for (l = js->links1[*grid]; l; l = ld->next) {
+						ld = &js->linkdat[l];
+						if (INSET(WORDS(d), ld->w) || !(before >> ld->prev & after >> ld->post & 1))
+							continue; // Does not fit around xy
+						tstxy = xy + ld->ofs * js->gridxmax;
+						if (tstxy >= 0 && js->xy2level[tstxy] == d->firstlevel)
+							hasplace += place_vword(js, d, tstxy, ld->w);
+					}
+				}
+				if (hasplace)
+					return;
+			}
+		}
+
+		// Locate 'adjacent' word
+		hasplace = 0;
+		for (xy = js->level2xy[level], grid = d->grid + xy, attr = ATTR(d) + xy;
+		     !ISBORDER(*attr);
+		     xy += js->gridxmax - 1, grid += js->gridxmax - 1, attr += js->gridxmax - 1) {
+			if (*attr & TODOH) {
+				before = cell_mask(js, d, xy - 1, js->gridxmax);
+				after = cell_mask(js, d, xy + 1, js->gridxmax);
+				for (l = js->links1[*grid]; l; l = ld->next) {
+					ld = &js->linkdat[l];
+					if (INSET(WORDS(d), ld->w) || !(before >> ld->prev & after >> ld->post & 1))
+						continue; // Does not fit around xy
+					tstxy = xy + ld->ofs;
+					if (ISSTAR(d->grid[tstxy]))
+						hasplace += place_hword(js, d, tstxy, ld->w);
+					if (js->opt_symmetrical) {
+						if (ISSTAR(d->grid[js->gridsize - 1 - (tstxy + js->wlen[ld->w] - 1)]))
+							hasplace += place_hword(js, d, tstxy, ld->w);
+					}
+				}
+			}
+			if (*attr & TODOV) {
+				before = cell_mask(js, d, xy - js->gridxmax, 1);
+				after = cell_mask(js, d, xy + js->gridxmax, 1);
+				for (l = js->links1[*grid]; l; l = ld->next) {
+					ld = &js->linkdat[l];
+					if (INSET(WORDS(d), ld->w) || !(before >> ld->prev & after >> ld->post & 1))
+						continue; // Does not fit around xy
+					tstxy = xy + ld->ofs * js->gridxmax;
+					if (tstxy < 0)
+						continue; // Starts above the grid
+					if (ISSTAR(d->grid[tstxy]))
+						hasplace += place_vword(js, d, tstxy, ld->w);
+					if (js->opt_symmetrical) {
+						if (ISSTAR(d->grid[js->gridsize - 1 - (tstxy + js->wlen[ld->w] * js->gridxmax - js->gridxmax)]))
+							hasplace += place_vword(js, d, tstxy, ld->w);
+					}
+				}
+			}
+			if (hasplace)
+				return;
+		}
+
+		// Locate word fragments (just one word please)
+		hasplace = 0;
+		hasfree = 0;
+		for (xy = js->level2xy[level], grid = d->grid + xy, attr = ATTR(d) + xy;
+		     !ISBORDER(*attr);
+		     xy += js->gridxmax - 1, grid += js->gridxmax - 1, attr += js->gridxmax - 1) {
+			if (ISFREE(*grid))
+				hasfree = 1;
+			if (*attr & TODOH) {
+				before = cell_mask(js, d, xy - 1, js->gridxmax);
+				after = cell_mask(js, d, xy + 1, js->gridxmax);
+				cnt = 0;
+				for (l = js->links1[*grid]; l; l = ld->next) {
+					ld = &js->linkdat[l];
+					if (INSET(WORDS(d), ld->w) || !(before >> ld->prev & after >> ld->post & 1))
+						continue; // Does not fit around xy
+					tstxy = xy + ld->ofs;
+					if (!ISSTAR(d->grid[tstxy]))
+						cnt += place_hword(js, d, tstxy, ld->w);
+					if (!js->opt_symmetrical) {
+						if (cnt != 0)
+							break;
+					}
+				}
+				if (cnt == 0) {
+					// Speed things up (Not 100% correct, but it's fast)
+					mark_grid(js, d, xy, 'H');
+					mark_grid(js, d, xy - 1, '*');
+					mark_grid(js, d, xy + 1, '*');
+					if (js->opt_symmetrical) {
+						if (ISCHAR(d->grid[js->gridsize - 1 - (xy - 1)])) return; // Arghh
+						mark_grid(js, d, js->gridsize - 1 - (xy - 1), '*');
+						if (ISCHAR(d->grid[js->gridsize - 1 - (xy + 1)])) return; // Arghh
+						mark_grid(js, d, js->gridsize - 1 - (xy + 1), '*');
+					}
+				}
+				hasplace += cnt;
+			}
+			if (*attr & TODOV) {
+				before = cell_mask(js, d, xy - js->gridxmax, 1);
+				after = cell_mask(js, d, xy + js->gridxmax, 1);
+				cnt = 0;
+				for (l = js->links1[*grid]; l; l = ld->next) {
+					ld = &js->linkdat[l];
+					if (INSET(WORDS(d), ld->w) || !(before >> ld->prev & after >> ld->post & 1))
+						continue; // Does not fit around xy
+					tstxy = xy + ld->ofs * js->gridxmax;
+					if (tstxy < 0)
+						continue; // Starts above the grid
+					if (!ISSTAR(d->grid[tstxy]))
+						cnt += place_vword(js, d, tstxy, ld->w);
+					if (!js->opt_symmetrical) {
+						if (cnt != 0)
+							break;
+					}
+				}
+				if (cnt == 0) {
+					// Speed things up (Not 100% correct, but it's fast)
+					mark_grid(js, d, xy, 'V');
+					mark_grid(js, d, xy - js->gridxmax, '*');
+					mark_grid(js, d, xy + js->gridxmax, '*');
+					if (js->opt_symmetrical) {
+						if (ISCHAR(d->grid[js->gridsize - 1 - (xy - js->gridxmax)])) return; // Arghh
+						mark_grid(js, d, js->gridsize - 1 - (xy - js->gridxmax), '*');
+						if (ISCHAR(d->grid[js->gridsize - 1 - (xy + js->gridxmax)])) return; // Arghh
+						mark_grid(js, d, js->gridsize - 1 - (xy + js->gridxmax), '*');
+					}
+				}
+				hasplace += cnt;
+			}
+			if (hasplace)
+				return;
+		}
+
+		// Update hotspot
+		if (!hasfree)
+			d->firstlevel = level + 1;
+	}
+}
+
+/*
+ * Telemetry, a JSON record per round. Histogram bin 0 counts zeroes, bin i
+ * values from 2^(i-1) up to 2^i, the last bin everything beyond.
+ */
+
+static int hist_bin(long v) {
+	int i;
+
+	if (v <= 0)
+		return 0;
+	i = 64 - __builtin_clzl((unsigned long) v);
+	return i < HISTMAX ? i : HISTMAX - 1;
+}
+
+static void count_scan(struct jigsaw *js, long ns, int numchild) {
+	js->scanns += ns;
+	js->scanhist[hist_bin(ns)]++;
+	js->childhist[hist_bin(numchild)]++;
+}
+
+static void put_hist(FILE *f, const char *name, long *hist) {
+	int i, n;
+
+	for (n = HISTMAX; n > 0 && hist[n - 1] == 0; n--)
+		;
+	fprintf(f, ",\"%s\":[", name);
+	for (i = 0; i < n; i++)
+		fprintf(f, i ? ",%ld" : "%ld", hist[i]);
+	fprintf(f, "]");
+}
+
+static void write_telemetry(struct jigsaw *js) {
+	FILE *f = js->opt_telemetry;
+	struct node *d;
+	long numfree = 0, numscanned = 0, cnt;
+	int i, pool, sep = 0;
+	double now = elapsed(js);
+
+	// Free slots, shared and those the workers keep
+	for (pool = 0; pool < POOLMAX; pool++) {
+		for (d = js->freenode[pool]; d; d = d->next)
+			numfree++;
+		for (i = 0; i < js->opt_threads; i++)
+			for (d = js->workers[i].freenode[pool]; d; d = d->next)
+				numfree++;
+	}
+	for (i = 0; i < HISTMAX; i++)
+		numscanned += js->scanhist[i];
+
+	fprintf(f, "{\"round\":%d,\"start\":%.6f,\"time\":%.6f,\"scantime\":%.6f,\"word\":%d,\"score\":%f,"
+		"\"nodemax\":%d,\"scanned\":%ld,\"node\":%d,\"generated\":%d,\"dedup\":%d,\"dropped\":%d,\"pruned\":%d,\"kept\":%d,"
+		"\"cut\":%d,\"paircut\":%d,\"hashtst\":%d,\"hashhit\":%d,\"free\":%ld,\"memused\":%ld,\"mempeak\":%ld,\"slots\":%d,\"malloc\":%ld,"
+		"\"scorelo\":%f,\"scorehi\":%f,\"buckets\":{",
+		js->totround, js->roundstart, now - js->roundstart, js->scanns / 1e9, js->solution->numword, js->solution->score,
+		js->nodemax, numscanned, js->numscan, js->numchild, js->numdup, js->numreject, js->numprune, js->realnumnode,
+		js->cutbucket[0], js->cutbucket[1], js->hashtst, js->hashhit, numfree, js->memused, js->mempeak, js->nummalloc, js->nummallocbytes,
+		js->scorelo, js->scorelo + (SCOREMAX - 1) / js->scorescale);
+
+	// Occupancy of scores[], best first
+	for (i = SCOREMAX - 1; i >= 0; i--) {
+		for (cnt = 0, d = js->scores[i]; d; d = d->next)
+			cnt++;
+		if (cnt)
+			fprintf(f, "%s\"%d\":%ld", sep++ ? "," : "", i, cnt);
+	}
+	fprintf(f, "}");
+	put_hist(f, "scanns", js->scanhist);
+	put_hist(f, "children", js->childhist);
+	fprintf(f, "}\n");
+	fflush(f);
+}
+
+/*
+ * Scan the jobs of the current batch until none are left
+ */
+
+static void run_jobs(struct jigsaw *js, struct worker *w) {
+	struct job *j;
+	int i, cnt;
+	long t = 0;
+
+	curworker = w;
+	for (cnt = 0;; cnt++) {
+		i = __sync_fetch_and_add(&js->nextjob, 1);
+		if (i >= js->numjob)
+			break;
+		j = &js->jobs[i];
+		if ((j->d->numadj > 0 || !js->skipscan) && !__atomic_load_n(&js->timeout, __ATOMIC_RELAXED)) {
+			if (js->opt_telemetry)
+				t = nsecs();
+			curjob = j;
+			expand_node(js, j->d, w->scratch);
+			scan_grid(js, w->scratch);
+			curjob = NULL;
+			if (js->opt_telemetry)
+				j->scanns = nsecs() - t;
+		}
+	}
+	curworker = NULL;
+
+	pthread_mutex_lock(&js->poolmutex);
+	js->donejob += cnt;
+	if (w != &js->workers[0] && --js->numactive == 0)
+		pthread_cond_signal(&js->donecond);
+	pthread_mutex_unlock(&js->poolmutex);
+}
+
+static void *worker_main(void *arg) {
+	struct worker *w = (struct worker *) arg;
+	struct jigsaw *js = w->js;
+	int seen = 0;
+
+	w->cpubase = thread_cpu() - w->cputime;
+	pthread_mutex_lock(&js->poolmutex);
+	for (;;) {
+		while (!js->quit && (!js->batchopen || js->batchnr == seen))
+			pthread_cond_wait(&js->batchcond, &js->poolmutex);
+		if (js->quit)
+			break;
+		seen = js->batchnr;
+		js->numactive++;
+		pthread_mutex_unlock(&js->poolmutex);
+
+		run_jobs(js, w);
+
+		pthread_mutex_lock(&js->poolmutex);
+	}
+	pthread_mutex_unlock(&js->poolmutex);
+	return NULL;
+}
+
+/*
+ * Let the workers exit and hand their private free lists back
+ */
+
+static void stop_workers(struct jigsaw *js) {
+	struct node *d;
+	int i, pool;
+
+	pthread_mutex_lock(&js->poolmutex);
+	js->quit = 1;
+	pthread_cond_broadcast(&js->batchcond);
+	pthread_mutex_unlock(&js->poolmutex);
+
+	for (i = 1; i <= js->numworker; i++)
+		pthread_join(js->workers[i].tid, NULL);
+	js->numworker = 0;
+	js->quit = 0;
+
+	for (i = 0; i < js->opt_threads; i++) {
+		for (pool = 0; pool < POOLMAX; pool++) {
+			while ((d = js->workers[i].freenode[pool])) {
+				js->workers[i].freenode[pool] = d->next;
+				d->next = js->freenode[pool];
+				js->freenode[pool] = d;
+			}
+		}
+	}
+}
+
+/*
+ * Multi-threaded version of the round loop in kick_ass(). Nodes are scanned
+ * speculatively in batches, the results are merged in todo order applying
+ * the same NODEMAX cut-off as the serial loop. Returns the nodes left when
+ * time is up.
+ */
+
+static struct node *scan_batches(struct jigsaw *js, struct node *todonode) {
+	struct node *d, *next;
+	struct job *j;
+	int i;
+
+	while (todonode && !deadline(js)) {
+		// Collect a batch
+		for (js->numjob = 0; todonode && js->numjob < js->opt_threads * BATCHNODES; js->numjob++) {
+			j = &js->jobs[js->numjob];
+			j->d = todonode;
+			j->child = j->best = NULL;
+			j->numreject = j->numnode = j->numchild = 0;
+			j->scanns = 0;
+			j->childtail = &j->child;
+			todonode = todonode->next;
+		}
+
+		// Release the workers, NODEMAX cannot decrease during the batch
+		pthread_mutex_lock(&js->poolmutex);
+		js->skipscan = (js->numnode >= js->nodemax);
+		js->nextjob = js->donejob = 0;
+		js->batchnr++;
+		js->batchopen = 1;
+		pthread_cond_broadcast(&js->batchcond);
+		pthread_mutex_unlock(&js->poolmutex);
+
+		run_jobs(js, &js->workers[0]);
+
+		pthread_mutex_lock(&js->poolmutex);
+		while (js->donejob < js->numjob || js->numactive > 0)
+			pthread_cond_wait(&js->donecond, &js->poolmutex);
+		js->batchopen = 0;
+		pthread_mutex_unlock(&js->poolmutex);
+
+		// Merge as if scanned serially
+		for (i = 0; i < js->numjob; i++) {
+			j = &js->jobs[i];
+			if (j->d->numadj > 0 || js->numnode < js->nodemax) {
+				if (j->d->numadj == 0) js->numscan++;
+				if (j->best && j->best->numword > js->solution->numword)
+					new_solution(js, j->best);
+				js->numnode += j->numnode;
+				js->numreject += j->numreject;
+				js->numchild += j->numchild;
+				if (js->opt_telemetry)
+					count_scan(js, j->scanns, j->numchild);
+				for (d = j->child; d; d = next) {
+					next = d->next;
+					add_node(js, d);
+				}
+			} else {
+				for (d = j->child; d; d = next) {
+					next = d->next;
+					release_node(js, d);
+				}
+			}
+			free(j->best);
+			release_node(js, j->d);
+		}
+	}
+	return todonode;
+}
+
+/*
+ * Checkpoints. The state of a round between two nodes is written as a stream
+ * of variable length integers: the options, the word list, the statistics of
+ * the round and the solution, then all stored nodes in use with parents
+ * before their children, and last the todo list and scores[] as node ids.
+ */
+
+struct ckent {
+	struct node	*d;				// Written node
+	int		seqnr;				// Its seqnr, which holds -id meanwhile
+};
+
+struct ckstream {
+	FILE		*f;				// Written to, NULL when reading
+	uint8_t		*p, *end;			// Next byte, end of data or buffer
+	uint64_t	sum;				// Checksum of the bytes flushed
+	int		error;				// Read past the end, or write failed
+	uint8_t		buf[CKBUFSIZE + 16];		// Write buffer, a varint may overrun
+};
+
+/*
+ * FNV-1a taken a word at a time, the trailer of a checkpoint
+ */
+
+static uint64_t ck_sum(uint64_t sum, const uint8_t *p, size_t len) {
+	uint64_t w;
+
+	for (; len >= 8; p += 8, len -= 8) {
+		memcpy(&w, p, 8);
+		sum = (sum ^ w) * 0x100000001b3ULL;
+	}
+	for (; len; p++, len--)
+		sum = (sum ^ *p) * 0x100000001b3ULL;
+	return sum;
+}
+
+/*
+ * Write the buffer, only the last write is not a full buffer so the words of
+ * the checksum line up with those of the file
+ */
+
+static void ck_flush(struct ckstream *ck) {
+	size_t len, over;
+
+	len = ck->p - ck->buf;
+	if (len > CKBUFSIZE)
+		len = CKBUFSIZE;
+	over = ck->p - ck->buf - len;
+	ck->sum = ck_sum(ck->sum, ck->buf, len);
+	if (fwrite(ck->buf, 1, len, ck->f) != len)
+		ck->error = 1;
+	memmove(ck->buf, ck->buf + len, over);
+	ck->p = ck->buf + over;
+}
+
+static void put_uint(struct ckstream *ck, uint64_t v) {
+	while (v >= 0x80) {
+		*ck->p++ = (uint8_t) v | 0x80;
+		v >>= 7;
+	}
+	*ck->p++ = (uint8_t) v;
+	if (ck->p >= ck->end)
+		ck_flush(ck);
+}
+
+static void put_int(struct ckstream *ck, int64_t v) {
+	put_uint(ck, ((uint64_t) v << 1) ^ (uint64_t) (v >> 63));
+}
+
+static void put_bytes(struct ckstream *ck, const void *data, size_t len) {
+	const uint8_t *p = (const uint8_t *) data;
+	size_t n;
+
+	while (len) {
+		n = ck->end - ck->p;
+		if (n > len)
+			n = len;
+		memcpy(ck->p, p, n);
+		ck->p += n;
+		p += n;
+		len -= n;
+		if (ck->p >= ck->end)
+			ck_flush(ck);
+	}
+}
+
+/*
+ * Reading past the end returns zeros, callers test error when done
+ */
+
+static uint64_t get_uint(struct ckstream *ck) {
+	uint64_t v = 0;
+	int shift;
+
+	for (shift = 0; shift < 64; shift += 7) {
+		if (ck->p == ck->end) {
+			ck->error = 1;
+			return 0;
+		}
+		v |= (uint64_t) (*ck->p & 0x7f) << shift;
+		if (!(*ck->p++ & 0x80))
+			break;
+	}
+	return v;
+}
+
+static int64_t get_int(struct ckstream *ck) {
+	uint64_t v = get_uint(ck);
+
+	return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+static int get_bytes(struct ckstream *ck, void *data, size_t len) {
+	if ((size_t) (ck->end - ck->p) < len) {
+		ck->error = 1;
+		return 1;
+	}
+	memcpy(data, ck->p, len);
+	ck->p += len;
+	return 0;
+}
+
+/*
+ * Write a node unless already written, its ancestors go first. Returns its
+ * id, 0 for none, -1 when out of memory. Written nodes carry their id in
+ * seqnr until the checkpoint is complete, ids start at 1.
+ */
+
+static int write_node(struct jigsaw *js, struct ckstream *ck, struct node *d) {
+	struct adj *a, *aend;
+	struct ckent *p;
+	int parent;
+
+	if (d == NULL)
+		return 0;
+	if (d->seqnr < 0)
+		return -d->seqnr;
+	if ((parent = write_node(js, ck, d->parent)) < 0)
+		return -1;
+	if (js->numckid == js->maxckid) {
+		p = (struct ckent *) realloc(js->cknodes, (js->maxckid ? 2 * js->maxckid : 4096) * sizeof(struct ckent));
+		if (p == NULL)
+			return -1;
+		js->cknodes = p;
+		js->maxckid = js->maxckid ? 2 * js->maxckid : 4096;
+	}
+
+	put_uint(ck, 1);
+	put_uint(ck, parent);
+	put_uint(ck, d->numadj);
+	put_uint(ck, d->nummark);
+	put_int(ck, d->seqnr);
+	put_int(ck, d->numword);
+	put_int(ck, d->numchar);
+	put_int(ck, d->numconn);
+	put_int(ck, d->numfree);
+	put_int(ck, d->firstlevel);
+	put_int(ck, d->lastlevel);
+	put_int(ck, d->symdir);
+	put_int(ck, d->symxy);
+	put_int(ck, d->symlen);
+	put_int(ck, d->dir);
+	put_int(ck, d->xy);
+	put_int(ck, d->word);
+	put_bytes(ck, &d->hash, sizeof(d->hash));
+	put_bytes(ck, &d->score, sizeof(d->score));
+	for (a = d->adj, aend = a + d->numadj; a < aend; a++) {
+		put_int(ck, a->l);
+		put_int(ck, a->xy);
+		put_int(ck, a->dir);
+	}
+	for (aend += d->nummark; a < aend; a++) {
+		put_int(ck, a->xy);
+		put_int(ck, a->dir);
+	}
+
+	js->cknodes[js->numckid].d = d;
+	js->cknodes[js->numckid].seqnr = d->seqnr;
+	d->seqnr = -++js->numckid;
+	return js->numckid;
+}
+
+static void write_list(struct ckstream *ck, struct node *list) {
+	struct node *d;
+	int cnt;
+
+	for (cnt = 0, d = list; d; d = d->next)
+		cnt++;
+	put_uint(ck, cnt);
+	for (d = list; d; d = d->next)
+		put_uint(ck, -d->seqnr);
+}
+
+/*
+ * Save the round with todonode the nodes it has left. The file is replaced
+ * only once the new one is complete.
+ */
+
+static int write_checkpoint(struct jigsaw *js, struct node *todonode) {
+	struct ckstream *ck;
+	struct node *d;
+	char *tmpname, word[WORDLENMAX];
+	int i, p, w, ret = JIGSAW_OK;
+
+	ck = (struct ckstream *) malloc(sizeof(struct ckstream));
+	tmpname = (char *) malloc(strlen(js->opt_checkpoint) + 5);
+	if (ck == NULL || tmpname == NULL) {
+		free(ck);
+		free(tmpname);
+		return JIGSAW_ENOMEM;
+	}
+	sprintf(tmpname, "%s.tmp", js->opt_checkpoint);
+	ck->f = fopen(tmpname, "wb");
+	if (ck->f == NULL) {
+		free(ck);
+		free(tmpname);
+		return JIGSAW_EIO;
+	}
+	ck->p = ck->buf;
+	ck->end = ck->buf + CKBUFSIZE;
+	ck->sum = CKSUMINIT;
+	ck->error = 0;
+
+	// Options and word list
+	put_bytes(ck, CKMAGIC, 8);
+	put_uint(ck, js->opt_width);
+	put_uint(ck, js->opt_height);
+	put_uint(ck, js->opt_nodemax);
+	put_uint(ck, js->opt_memmax);
+	put_uint(ck, js->opt_symmetrical);
+	put_uint(ck, js->opt_start);
+	put_uint(ck, js->opt_startmin);
+	put_bytes(ck, &js->opt_weight, sizeof(js->opt_weight));
+	put_bytes(ck, js->opt_eval, sizeof(js->opt_eval));
+	put_uint(ck, js->numword);
+	for (w = 0; w < js->numword; w++) {
+		for (i = 1; i < js->wlen[w] - 1; i++)
+			word[i - 1] = js->wordbase[w][i] + BASE;
+		put_uint(ck, js->wlen[w] - 2);
+		put_bytes(ck, word, js->wlen[w] - 2);
+	}
+
+	// Round statistics and frontier cut
+	put_uint(ck, js->numround);
+	put_uint(ck, js->seqnr);
+	put_uint(ck, js->incumbent);
+	put_uint(ck, js->numnode);
+	put_uint(ck, js->realnumnode);
+	put_uint(ck, js->numscan);
+	put_uint(ck, js->numreject);
+	put_uint(ck, js->numprune);
+	put_uint(ck, js->hashtst);
+	put_uint(ck, js->hashhit);
+	for (p = 0; p < 2; p++) {
+		put_uint(ck, js->cutbucket[p]);
+		put_uint(ck, js->numfrontier[p]);
+		for (i = 0; i < SCOREMAX; i++)
+			put_uint(ck, js->bucketcnt[p][i]);
+	}
+	put_bytes(ck, &js->scorelo, sizeof(js->scorelo));
+	put_bytes(ck, &js->scorescale, sizeof(js->scorescale));
+
+	// Solution
+	put_int(ck, js->solution->seqnr);
+	put_int(ck, js->solution->numword);
+	put_int(ck, js->solution->numchar);
+	put_int(ck, js->solution->numconn);
+	put_int(ck, js->solution->firstlevel);
+	put_int(ck, js->solution->lastlevel);
+	put_bytes(ck, &js->solution->score, sizeof(js->solution->score));
+	put_bytes(ck, js->solution->grid, 2 * js->gridsize);
+
+	// Nodes, then the lists they are in
+	js->numckid = 0;
+	for (d = todonode; d && ret == JIGSAW_OK; d = d->next)
+		if (write_node(js, ck, d) < 0)
+			ret = JIGSAW_ENOMEM;
+	for (i = 0; i < SCOREMAX && ret == JIGSAW_OK; i++)
+		for (d = js->scores[i]; d && ret == JIGSAW_OK; d = d->next)
+			if (write_node(js, ck, d) < 0)
+				ret = JIGSAW_ENOMEM;
+	put_uint(ck, 0);
+
+	if (ret == JIGSAW_OK) {
+		write_list(ck, todonode);
+		for (i = 0; i < SCOREMAX; i++) {
+			if (js->scores[i]) {
+				put_uint(ck, i + 1);
+				write_list(ck, js->scores[i]);
+			}
+		}
+		put_uint(ck, 0);
+	}
+	for (i = 0; i < js->numckid; i++)
+		js->cknodes[i].d->seqnr = js->cknodes[i].seqnr;
+
+	ck_flush(ck);
+	if (fwrite(&ck->sum, sizeof(ck->sum), 1, ck->f) != 1)
+		ck->error = 1;
+	if (ck->error && ret == JIGSAW_OK)
+		ret = JIGSAW_EIO;
+	if (fclose(ck->f) && ret == JIGSAW_OK)
+		ret = JIGSAW_EIO;
+	if (ret == JIGSAW_OK && rename(tmpname, js->opt_checkpoint))
+		ret = JIGSAW_EIO;
+	if (ret != JIGSAW_OK)
+		unlink(tmpname);
+	free(tmpname);
+	free(ck);
+
+	if (js->opt_debug && ret == JIGSAW_OK)
+		fprintf(stderr, "%s Checkpoint round:%d node:%d\n", elapsedstr(js), js->numround, js->numckid);
+	return ret;
+}
+
+/*
+ * Rebuild the round from what jigsaw_restore() left of the checkpoint. The
+ * duplicate table is refilled with the grids in scores[].
+ */
+
+static int read_checkpoint(struct jigsaw *js) {
+	struct node *d, **ids = NULL, **grown, **tail;
+	struct adj *a, *aend;
+	int i, p, cnt, numid = 0, maxid = 0, parent, numadj, nummark;
+	int ret = JIGSAW_EFORMAT;
+	uint64_t id;
+	uint32_t ix;
+	struct ckstream ckdata, *ck = &ckdata;
+
+	ck->f = NULL;
+	ck->p = (uint8_t *) js->resumedata;
+	ck->end = ck->p + js->resumesize;
+	ck->error = 0;
+
+	// Round statistics and frontier cut
+	js->numround = get_uint(ck);
+	js->seqnr = get_uint(ck);
+	js->incumbent = get_uint(ck);
+	js->numnode = get_uint(ck);
+	js->realnumnode = get_uint(ck);
+	js->numscan = get_uint(ck);
+	js->numreject = get_uint(ck);
+	js->numprune = get_uint(ck);
+	js->hashtst = get_uint(ck);
+	js->hashhit = get_uint(ck);
+	for (p = 0; p < 2; p++) {
+		js->cutbucket[p] = get_uint(ck);
+		js->numfrontier[p] = get_uint(ck);
+		for (i = 0; i < SCOREMAX; i++)
+			js->bucketcnt[p][i] = get_uint(ck);
+		if (js->cutbucket[p] < 0 || js->cutbucket[p] >= SCOREMAX)
+			goto fail;
+	}
+	if (get_bytes(ck, &js->scorelo, sizeof(js->scorelo)) || get_bytes(ck, &js->scorescale, sizeof(js->scorescale)))
+		goto fail;
+	if (!(js->scorescale > 0))
+		goto fail;
+
+	// Solution
+	js->solution->seqnr = get_int(ck);
+	js->solution->numword = get_int(ck);
+	js->solution->numchar = get_int(ck);
+	js->solution->numconn = get_int(ck);
+	js->solution->firstlevel = get_int(ck);
+	js->solution->lastlevel = get_int(ck);
+	if (get_bytes(ck, &js->solution->score, sizeof(js->solution->score)) ||
+	    get_bytes(ck, js->solution->grid, 2 * js->gridsize))
+		goto fail;
+
+	// Nodes, parents come first
+	while (get_uint(ck) == 1) {
+		if (numid == maxid) {
+			maxid = maxid ? 2 * maxid : 4096;
+			grown = (struct node **) realloc(ids, maxid * sizeof(struct node *));
+			if (grown == NULL) {
+				ret = JIGSAW_ENOMEM;
+				goto fail;
+			}
+			ids = grown;
+		}
+		parent = get_uint(ck);
+		numadj = get_uint(ck);
+		nummark = get_uint(ck);
+		if (parent < 0 || parent > numid || numadj < 0 || numadj > ADJMAX || nummark < 0 || nummark > 3 * js->gridsize)
+			goto fail;
+		d = mallocnode(js, NODESIZE(numadj + nummark), 0);
+		if (d == NULL) {
+			ret = JIGSAW_ENOMEM;
+			goto fail;
+		}
+		ids[numid++] = d;
+		d->next = NULL;
+		d->refcnt = 0;
+		d->parent = parent ? ids[parent - 1] : NULL;
+		if (d->parent)
+			d->parent->refcnt++;
+		d->numadj = numadj;
+		d->nummark = nummark;
+		d->seqnr = get_int(ck);
+		d->numword = get_int(ck);
+		d->numchar = get_int(ck);
+		d->numconn = get_int(ck);
+		d->numfree = get_int(ck);
+		d->firstlevel = get_int(ck);
+		d->lastlevel = get_int(ck);
+		d->symdir = get_int(ck);
+		d->symxy = get_int(ck);
+		d->symlen = get_int(ck);
+		d->dir = get_int(ck);
+		d->xy = get_int(ck);
+		d->word = get_int(ck);
+		if (get_bytes(ck, &d->hash, sizeof(d->hash)) || get_bytes(ck, &d->score, sizeof(d->score)))
+			goto fail;
+		if ((d->dir != 'H' && d->dir != 'V') || d->xy < 0 || d->xy >= js->gridsize ||
+		    d->word < 0 || d->word >= js->numword || d->numword != (d->parent ? d->parent->numword : 0) + 1 ||
+		    d->numfree < 0 || d->numchar < 0 || d->numconn < 0 || 2 * d->numfree + d->numchar - d->numconn < 0 ||
+		    2 * d->numfree + d->numchar - d->numconn > 3 * js->gridsize ||
+		    d->firstlevel < 0 || d->lastlevel < 0 || d->lastlevel >= js->gridxmax + js->gridymax ||
+		    (d->symdir != 0 && d->symdir != 'H' && d->symdir != 'V') ||
+		    d->symxy < 0 || d->symxy >= js->gridsize || d->symlen < 0 || d->symlen > WORDLENMAX)
+			goto fail;
+		for (a = d->adj, aend = a + numadj; a < aend; a++) {
+			a->l = get_int(ck);
+			a->xy = get_int(ck);
+			a->dir = get_int(ck);
+			if (a->l < 0 || a->l >= js->numlinkdat || a->xy < 0 || a->xy >= js->gridsize ||
+			    (a->dir != 'H' && a->dir != 'V'))
+				goto fail;
+		}
+		for (aend += nummark; a < aend; a++) {
+			a->l = 0;
+			a->xy = get_int(ck);
+			a->dir = get_int(ck);
+			if (a->xy < 0 || a->xy >= js->gridsize || (a->dir != '*' && a->dir != 'H' && a->dir != 'V'))
+				goto fail;
+		}
+	}
+
+	// Nodes left in the round
+	tail = &js->resumetodo;
+	for (cnt = get_uint(ck); cnt > 0; cnt--) {
+		id = get_uint(ck);
+		if (id < 1 || id > (uint64_t) numid)
+			goto fail;
+		d = ids[id - 1];
+		d->refcnt++;
+		*tail = d;
+		tail = &d->next;
+	}
+
+	// Grids of the next round, duplicates are searched among them
+	memset(js->hashtab, 0, js->hashsize * sizeof(struct hashent));
+	js->hashused = 0;
+	js->frontiermem = 0;
+	while ((i = get_uint(ck)) != 0) {
+		if (--i >= SCOREMAX)
+			goto fail;
+		for (cnt = get_uint(ck); cnt > 0; cnt--) {
+			id = get_uint(ck);
+			if (id < 1 || id > (uint64_t) numid)
+				goto fail;
+			d = ids[id - 1];
+			d->refcnt++;
+			*js->scoretail[i] = d;
+			js->scoretail[i] = &d->next;
+			js->frontiermem += d->pool * POOLSTEP;
+			if (2 * (js->hashused + 1) > js->hashsize && grow_hash(js)) {
+				ret = JIGSAW_ENOMEM;
+				goto fail;
+			}
+			for (ix = d->hash & (js->hashsize - 1); js->hashtab[ix].d; ix = (ix + 1) & (js->hashsize - 1))
+				;
+			js->hashtab[ix].hash = d->hash;
+			js->hashtab[ix].stats = HASHSTATS(d);
+			js->hashtab[ix].d = d;
+			js->hashused++;
+		}
+	}
+	if (ck->error)
+		goto fail;
+
+	// Nodes nothing descends from are of no use
+	for (i = 0; i < numid; i++) {
+		if (ids[i]->refcnt == 0) {
+			ids[i]->refcnt = 1;
+			release_node(js, ids[i]);
+		}
+	}
+
+	// A round left empty is a round boundary
+	js->resumed = (js->resumetodo != NULL);
+	free(ids);
+	return JIGSAW_OK;
+
+fail:
+	// Nodes are not shared yet, drop them all
+	for (i = 0; i < numid; i++)
+		free_node(js, ids[i]);
+	for (i = 0; i < SCOREMAX; i++) {
+		js->scores[i] = NULL;
+		js->scoretail[i] = &js->scores[i];
+	}
+	memset(js->hashtab, 0, js->hashsize * sizeof(struct hashent));
+	js->hashused = 0;
+	js->resumetodo = NULL;
+	free(ids);
+	return ret;
+}
+
+/*
+ * Auto NODEMAX. A round places a word, the rounds to come are estimated from
+ * the share of the grid the solution has filled with as many words. The width
+ * is scaled so the next round takes its share of the time left, by at most a
+ * factor two per round.
+ */
+
+static void auto_width(struct jigsaw *js) {
+	double cells, filled, rounds, scale;
+
+	cells = js->opt_width * js->opt_height;
+	filled = cells - js->solution->numfree;
+	if (js->lasttime <= 0 || filled <= 0)
+		return;
+	rounds = js->solution->numword * (cells / filled - 1);
+	if (rounds < 1)
+		rounds = 1;
+
+	scale = (js->opt_timemax - time_used(js)) / rounds / js->lasttime;
+	if (scale > 2) scale = 2;
+	if (scale < 0.5) scale = 0.5;
+	scale *= js->autowidth;
+	js->autowidth = scale > AUTOMAX ? AUTOMAX : scale < AUTOMIN ? AUTOMIN : (int) scale;
+}
+
+static int kick_ass(struct jigsaw *js) {
+	struct node *d, *todonode;
+	int i, numchild = 0, ret = JIGSAW_OK;
+	long t = 0;
+	double width;
+
+	// Nodes are expanded into a private scratch node for scanning
+	for (i = 0; i < js->opt_threads; i++) {
+		js->workers[i].js = js;
+		if (js->workers[i].scratch == NULL)
+			js->workers[i].scratch = (struct node *) malloc(js->scratchsize);
+		if (js->workers[i].scratch == NULL)
+			return JIGSAW_ENOMEM;
+	}
+
+	if (js->opt_threads > 1) {
+		// Start the workers, main thread is worker 0
+		if (js->jobs == NULL)
+			js->jobs = (struct job *) malloc(js->opt_threads * BATCHNODES * sizeof(struct job));
+		if (js->jobs == NULL)
+			return JIGSAW_ENOMEM;
+		for (i = 1; i < js->opt_threads; i++) {
+			if (pthread_create(&js->workers[i].tid, NULL, worker_main, &js->workers[i])) {
+				stop_workers(js);
+				return JIGSAW_ETHREAD;
+			}
+			js->numworker++;
+		}
+	}
+
+	for (;;) {
+		// Pick up what the portfolio found meanwhile
+		sync_incumbent(js);
+
+		// Telemetry is per round, also of a continued one
+		if (js->opt_telemetry) {
+			js->roundstart = elapsed(js);
+			js->scanns = 0;
+			js->mempeak = js->memused;
+			memset(js->scanhist, 0, sizeof(js->scanhist));
+			memset(js->childhist, 0, sizeof(js->childhist));
+		}
+
+		if (js->resumed) {
+			// Continue the round of the checkpoint
+			todonode = js->resumetodo;
+			js->resumetodo = NULL;
+			js->resumed = 0;
+		} else {
+			// setup up some debugging statistics
+			js->realnumnode = js->numnode = js->numscan = 0;
+			js->hashtst = js->hashhit = js->numreject = js->numprune = 0;
+			js->numchild = js->numdup = 0;
+
+			// Every bucket is in play again
+			memset(js->bucketcnt, 0, sizeof(js->bucketcnt));
+			memset(js->cutbucket, 0, sizeof(js->cutbucket));
+			memset(js->numfrontier, 0, sizeof(js->numfrontier));
+			js->frontiermem = 0;
+
+			// Narrow the round when the last one would not fit in half the time left
+			if (js->opt_nodemax == 0 && !js->improving)
+				auto_width(js);
+			js->nodemax = js->improving ? IMPROVEWIDTH : js->opt_nodemax ? js->opt_nodemax : js->autowidth;
+			if (js->opt_timemax && js->lastnode > 0) {
+				width = (js->opt_timemax - time_used(js)) / 2.0 / js->lasttime;
+				if (width < 1) {
+					width *= js->lastnode;
+					if (width < js->nodemax)
+						js->nodemax = width >= 1 ? (int) width : 1;
+				}
+			}
+			js->roundused = js->opt_timemax ? time_used(js) : 0;
+
+			// gather all nodes into a single list with highest score first
+			d = todonode = NULL;
+			for (i = SCOREMAX - 1; i >= 0; i--) {
+				if (js->scores[i]) {
+					if (todonode == NULL)
+						d = todonode = sort_nodes(js->scores[i]);
+					else
+						d->next = sort_nodes(js->scores[i]);
+					while (d->next) d = d->next;
+					js->scores[i] = NULL;
+				}
+				js->scoretail[i] = &js->scores[i];
+			}
+			if (todonode)
+				fit_buckets(js, d->score, todonode->score);
+
+			// Duplicates are only searched within a round
+			memset(js->hashtab, 0, js->hashsize * sizeof(struct hashent));
+			js->hashused = 0;
+		}
+
+		// Ok babe, lets go!!!
+		if (js->opt_threads > 1) {
+			todonode = scan_batches(js, todonode);
+		} else {
+			while (todonode && !deadline(js)) {
+				d = todonode;
+				todonode = d->next;
+				if (d->numadj > 0 || js->numnode < js->nodemax) {
+					if (d->numadj == 0) js->numscan++;
+					if (js->opt_telemetry) {
+						t = nsecs();
+						numchild = js->numchild;
+					}
+					expand_node(js, d, js->workers[0].scratch);
+					scan_grid(js, js->workers[0].scratch);
+					if (js->opt_telemetry)
+						count_scan(js, nsecs() - t, js->numchild - numchild);
+				}
+				release_node(js, d);
+			}
+		}
+
+		// Totals of the solve
+		js->totround++;
+		js->totscan += js->numscan;
+		js->tothashtst += js->hashtst;
+		js->tothashhit += js->hashhit;
+		if (js->opt_telemetry)
+			write_telemetry(js);
+
+		// Test for timeouts
+		if (deadline(js)) {
+			// PRINT OUT YOUR SOLUTION BEFORE YOU GO!
+			/*
+			 * HELP, the algorithm must compleet well under 10 minutes.
+			 */
+			ret = js->error ? js->error : js->stop ? JIGSAW_STOPPED : JIGSAW_TIMEOUT;
+			if (!js->error && !js->timeout && js->opt_terminate && *js->opt_terminate) {
+				// Terminated, save the round to continue it later
+				ret = JIGSAW_STOPPED;
+				if (js->opt_checkpoint && !js->improving && (i = write_checkpoint(js, todonode)) != JIGSAW_OK)
+					ret = i;
+			}
+			for (; todonode; todonode = d) {
+				d = todonode->next;
+				release_node(js, todonode);
+			}
+			break;
+		}
+
+		if (js->opt_debug) {
+			fprintf(stderr, "%s word:%2d score:%f level:%2d/%2d node:%4d/%4d/%4d/%d hash:%3d/%3d fp:%.2f%% cut:%d/%d prune:%d mem:%ldM\n",
+				elapsedstr(js), js->solution->numword, js->solution->score,
+				js->solution->firstlevel, js->solution->lastlevel, js->numscan, js->numnode,
+				js->realnumnode, js->nodemax, js->hashtst, js->hashhit, js->hashtst ? 100.0 * js->hashhit / js->hashtst : 0.0,
+				js->cutbucket[0], js->numreject, js->numprune, js->memused >> 20);
+			if (js->opt_dump) dump_grid(js, js->solution, stdout);
+		}
+
+		// Ass kicked?
+		if (js->realnumnode == 0)
+			break;
+
+		// Cost of the round, to size the next
+		if (js->opt_timemax) {
+			js->lasttime = time_used(js) - js->roundused;
+			js->lastnode = js->numnode;
+		}
+
+		// Save the frontier every few rounds
+		js->numround++;
+		if (js->opt_checkpoint && js->opt_checkrounds && !js->improving && js->numround % js->opt_checkrounds == 0) {
+			ret = write_checkpoint(js, NULL);
+			if (ret != JIGSAW_OK)
+				break;
+		}
+	}
+
+	stop_workers(js);
+	return ret;
+}
+
+/*
+ * Improvement. Once the search is done the time left goes to large
+ * neighbourhood search on the solution: the words in a window of the grid
+ * are taken out and a narrow beam places words anywhere they cross the
+ * words that stay. Sparse windows go first. The first pass takes nothing
+ * out, it fills what the search gave up on. A pass only counts when it
+ * beats the solution, the improvement ends when no window does.
+ */
+
+struct placed {
+	int		dir, xy, word;			// As in a stored node
+	int		comp;				// Union-find of crossing words
+};
+
+struct window {
+	int		x, y;				// Top-left cell
+	int		numchar;			// # characters in it
+};
+
+/*
+ * Read the words back from the solution grid. Returns how many, -1 when a
+ * run of characters is not in the word list.
+ */
+
+static int find_words(struct jigsaw *js, struct placed *pl, uint8_t *used) {
+	uint8_t *grid = js->solution->grid, line[WORDLENMAX];
+	int xy, dir, step, len, w, num = 0;
+
+	memset(used, 0, js->wordsetsize);
+	for (xy = 0; xy < js->gridsize; xy++) {
+		if (!ISCHAR(grid[xy]))
+			continue;
+		for (dir = 'H'; dir; dir = dir == 'H' ? 'V' : 0) {
+			step = dir == 'H' ? 1 : js->gridxmax;
+			if (ISCHAR(grid[xy - step]) || !ISCHAR(grid[xy + step]))
+				continue; // Not the start of a word
+			for (len = 0; ISCHAR(grid[xy + len * step]); len++) {
+				if (len == WORDLENMAX - 2)
+					return -1;
+				line[len] = grid[xy + len * step];
+			}
+			for (w = 0; w < js->numword; w++)
+				if (js->wlen[w] == len + 2 && !INSET(used, w) && memcmp(js->wordbase[w] + 1, line, len) == 0)
+					break;
+			if (w == js->numword)
+				return -1;
+			BITSET(used, w);
+			pl[num].dir = dir;
+			pl[num].xy = xy - step;
+			pl[num].word = w;
+			pl[num].comp = num;
+			num++;
+		}
+	}
+	return num;
+}
+
+static int find_comp(struct placed *pl, int i) {
+	while (pl[i].comp != i)
+		i = pl[i].comp = pl[pl[i].comp].comp;
+	return i;
+}
+
+/*
+ * Take out the words with a character in the window, those left touching a
+ * word they don't share a word with, and those no longer connected to the
+ * largest group of words that stay. Returns the # words that stay, comp is
+ * -1 for those taken out. owner has room for two grids.
+ */
+
+static int remove_window(struct jigsaw *js, struct placed *pl, int num, int *owner, struct window *win, int winw, int winh) {
+	int *hown = owner, *vown = owner + js->gridsize, *own, *size;
+	int i, xy, next, x, y, step, len, best, changed;
+
+	for (i = 0; i < num; i++) {
+		step = pl[i].dir == 'H' ? 1 : js->gridxmax;
+		for (xy = pl[i].xy + step, len = js->wlen[pl[i].word] - 2; len; xy += step, len--) {
+			x = xy % js->gridxmax;
+			y = xy / js->gridxmax;
+			if (win && x >= win->x && x < win->x + winw && y >= win->y && y < win->y + winh)
+				pl[i].comp = -1;
+		}
+	}
+
+	// Neighbouring characters must be part of the same word
+	do {
+		changed = 0;
+		for (xy = 0; xy < 2 * js->gridsize; xy++)
+			owner[xy] = -1;
+		for (i = 0; i < num; i++) {
+			if (pl[i].comp < 0)
+				continue;
+			step = pl[i].dir == 'H' ? 1 : js->gridxmax;
+			own = pl[i].dir == 'H' ? hown : vown;
+			for (xy = pl[i].xy + step, len = js->wlen[pl[i].word] - 2; len; xy += step, len--)
+				own[xy] = i;
+		}
+		for (xy = js->gridxmax + 1; xy < js->gridsize - js->gridxmax - 1; xy++) {
+			if (hown[xy] < 0 && vown[xy] < 0)
+				continue;
+			for (step = 1; step <= js->gridxmax; step += js->gridxmax - 1) {
+				next = xy + step;
+				own = step == 1 ? hown : vown;
+				if ((hown[next] < 0 && vown[next] < 0) || (own[xy] >= 0 && own[xy] == own[next]))
+					continue;
+				if (hown[xy] >= 0) pl[hown[xy]].comp = -1;
+				if (vown[xy] >= 0) pl[vown[xy]].comp = -1;
+				if (hown[next] >= 0) pl[hown[next]].comp = -1;
+				if (vown[next] >= 0) pl[vown[next]].comp = -1;
+				changed = 1;
+			}
+		}
+	} while (changed);
+
+	// Crossing words that stay are connected
+	for (xy = 0; xy < js->gridsize; xy++)
+		if (hown[xy] >= 0 && vown[xy] >= 0)
+			pl[find_comp(pl, hown[xy])].comp = find_comp(pl, vown[xy]);
+
+	// Keep the largest group, owner[] is free again
+	size = owner;
+	memset(size, 0, num * sizeof(int));
+	for (best = -1, i = 0; i < num; i++) {
+		if (pl[i].comp < 0)
+			continue;
+		pl[i].comp = find_comp(pl, i);
+		if (++size[pl[i].comp] > (best < 0 ? 0 : size[best]))
+			best = pl[i].comp;
+	}
+	if (best < 0)
+		return 0;
+	for (i = 0; i < num; i++)
+		if (pl[i].comp != best)
+			pl[i].comp = -1;
+	return size[best];
+}
+
+/*
+ * Store the words that stay as a chain of nodes, the way the search would
+ * have placed them one by one. Returns the last, NULL when out of memory.
+ */
+
+static struct node *chain_words(struct jigsaw *js, struct placed *pl, int num) {
+	struct node *full = js->cmpnode[0], *d = NULL, *n;
+	uint8_t *p;
+	int i, xy, step, pool, numfill = 0;
+
+	memset(full, 0, NODESIZE(0));
+	memcpy(full->grid, js->rootnode->grid, 3 * js->gridsize);
+	full->numfree = js->opt_width * js->opt_height;
+
+	for (i = 0; i < num; i++) {
+		if (pl[i].comp < 0)
+			continue;
+		step = pl[i].dir == 'H' ? 1 : js->gridxmax;
+		for (xy = pl[i].xy, p = js->wordbase[pl[i].word]; *p; xy += step, p++) {
+			if (ISFREE(full->grid[xy])) {
+				full->hash ^= ZOBRIST(xy, *p);
+				full->numfree--;
+			}
+			if (!ISSTAR(*p)) {
+				if (ISFREE(full->grid[xy]))
+					full->numchar++;
+				else
+					full->numconn++;
+			}
+		}
+		if (js->xy2level[xy - step] > full->lastlevel)
+			full->lastlevel = js->xy2level[xy - step];
+		put_word(js, full, pl[i].dir, pl[i].xy, pl[i].word);
+
+		n = mallocnode(js, NODESIZE(0), 0);
+		if (n == NULL) {
+			release_node(js, d);
+			return NULL;
+		}
+		pool = n->pool;
+		full->numword++;
+		full->dir = pl[i].dir;
+		full->xy = pl[i].xy;
+		full->word = pl[i].word;
+		memcpy(n, full, NODESIZE(0));
+		n->pool = pool;
+		n->parent = d;
+		n->refcnt = 1;
+		d = n;
+	}
+
+	// Regions the words that stay have closed off
+	for (xy = 0; d && xy < js->gridsize; xy++)
+		d->numfree -= fill_region(js, full->grid, FILL(full), &numfill, xy);
+	while (numfill)
+		full->grid[FILL(full)[--numfill]] = FREE;
+	return d;
+}
+
+/*
+ * Windows a third of the grid, overlapping by half, sparsest first
+ */
+
+static int make_windows(struct jigsaw *js, struct window *wins, int winw, int winh) {
+	struct window t;
+	int x, y, i, j, xy, maxx, maxy, num = 0;
+
+	maxx = js->opt_width - winw + 1;
+	maxy = js->opt_height - winh + 1;
+	for (y = 1;; y += winh / 2) {
+		if (y > maxy)
+			y = maxy;
+		for (x = 1;; x += winw / 2) {
+			if (x > maxx)
+				x = maxx;
+			wins[num].x = x;
+			wins[num].y = y;
+			wins[num].numchar = 0;
+			for (j = 0; j < winh; j++)
+				for (i = 0, xy = x + (y + j) * js->gridxmax; i < winw; i++, xy++)
+					if (ISCHAR(js->solution->grid[xy]))
+						wins[num].numchar++;
+
+			// Insert sorted, stable
+			for (i = num++; i > 0 && wins[i - 1].numchar > wins[i].numchar; i--) {
+				t = wins[i - 1];
+				wins[i - 1] = wins[i];
+				wins[i] = t;
+			}
+			if (x == maxx)
+				break;
+		}
+		if (y == maxy)
+			break;
+	}
+	return num;
+}
+
+static int improve(struct jigsaw *js) {
+	struct placed *pl;
+	struct window *wins;
+	struct node *d;
+	uint8_t *used;
+	int *owner, winw, winh, numwin = 0, win, num, numword, i, pass, ret = JIGSAW_OK;
+
+	// Mirrored words are not tracked
+	if (js->opt_symmetrical || js->solution->numword == 0)
+		return JIGSAW_OK;
+
+	winw = js->opt_width / 3;
+	if (winw < 4)
+		winw = js->opt_width < 4 ? js->opt_width : 4;
+	winh = js->opt_height / 3;
+	if (winh < 4)
+		winh = js->opt_height < 4 ? js->opt_height : 4;
+	pl = (struct placed *) malloc(js->gridsize * sizeof(struct placed));
+	owner = (int *) malloc(2 * js->gridsize * sizeof(int));
+	wins = (struct window *) malloc(js->gridsize * sizeof(struct window));
+	used = (uint8_t *) malloc(js->wordsetsize);
+	if (pl == NULL || owner == NULL || wins == NULL || used == NULL) {
+		ret = JIGSAW_ENOMEM;
+		goto done;
+	}
+
+	// Rounds of the search say nothing about the beam
+	js->improving = 1;
+	js->lasttime = 0;
+	js->lastnode = 0;
+
+	for (pass = 0, win = -1; !out_of_time(js); pass++) {
+		numword = js->solution->numword;
+		num = find_words(js, pl, used);
+		if (num < 0)
+			break;
+		if (win < 0)
+			numwin = make_windows(js, wins, winw, winh);
+		i = remove_window(js, pl, num, owner, win < 0 ? NULL : &wins[win], winw, winh);
+
+		if (js->opt_debug)
+			fprintf(stderr, "%s improve pass:%d window:%d/%d removed:%d word:%d\n",
+				elapsedstr(js), pass, win, numwin, num - i, numword);
+
+		d = i ? chain_words(js, pl, num) : NULL;
+		if (i && d == NULL) {
+			ret = JIGSAW_ENOMEM;
+			break;
+		}
+		if (d && max_words(js, d) > js->incumbent) {
+			// The beam starts from the words that stay
+			d->score = node_score(js, d);
+			d->seqnr = js->seqnr++;
+			d->next = NULL;
+			i = score_bucket(js, d->score);
+			*js->scoretail[i] = d;
+			js->scoretail[i] = &d->next;
+			ret = kick_ass(js);
+			if (ret != JIGSAW_OK)
+				break;
+		} else
+			release_node(js, d);
+
+		// Start over from an improved solution
+		if (js->solution->numword > numword)
+			win = -1;
+		else if (++win == numwin)
+			break;
+	}
+
+	// The time left is what this is for
+	if (ret == JIGSAW_TIMEOUT)
+		ret = JIGSAW_OK;
+	js->improving = 0;
+done:
+	free(pl);
+	free(owner);
+	free(wins);
+	free(used);
+	return ret;
+}
+
+
+/*
+ * Make room for another link, -1 when out of memory
+ */
+
+static int new_link(struct jigsaw *js) {
+	if (js->numlinkdat == js->maxlinkdat) {
+		js->maxlinkdat = js->maxlinkdat ? 2 * js->maxlinkdat : 4096;
+		js->linkdat = (struct link *) realloc(js->linkdat, js->maxlinkdat * sizeof(struct link));
+		if (js->linkdat == NULL)
+			return -1;
+	}
+	return js->numlinkdat++;
+}
+
+/*
+ * Load the word list and build the links. Returns a JIGSAW_E* code on failure.
+ */
+
+static int load_words(struct jigsaw *js, FILE *f) {
+	char line[80], c;
+	int i, w, done;
+	int x, y, ch, l;
+	int maxword, arenasize, arenaused, *wordofs = NULL;
+	uint8_t *p, word[sizeof(line) + 2];
+
+	// Load the words and check if they are valid
+	// Words are stored back to back, the arena moves while it grows
+	maxword = arenaused = 0;
+	arenasize = 4096;
+	js->wordarena = (uint8_t *) malloc(arenasize);
+	if (js->wordarena == NULL)
+		return JIGSAW_ENOMEM;
+	for (js->numword = 0;;) {
+		// Read line
+		if (fgets(line, sizeof(line), f) == NULL)
+			break;
+		// Copy the word
+		i = 0;
+		word[i++] = STAR;
+		for (; isalpha(c = line[i - 1]); i++)
+			word[i] = (uint8_t) (isupper(c) ? tolower(c) - BASE : c - BASE);
+		word[i++] = STAR;
+		word[i] = 0;
+		if (i > WORDLENMAX - 2) {
+			free(wordofs);
+			return JIGSAW_ELONG;
+		}
+		if (i <= 2)
+			continue;
+
+		if (js->numword == maxword) {
+			maxword = maxword ? 2 * maxword : 256;
+			wordofs = (int *) realloc(wordofs, maxword * sizeof(*wordofs));
+			js->wlen = (int *) realloc(js->wlen, maxword * sizeof(*js->wlen));
+		}
+		// Room for the terminator and for reading a whole line past the last word
+		if (arenaused + i + 1 + WORDLENMAX > arenasize) {
+			arenasize *= 2;
+			js->wordarena = (uint8_t *) realloc(js->wordarena, arenasize);
+		}
+		if (wordofs == NULL || js->wlen == NULL || js->wordarena == NULL) {
+			free(wordofs);
+			return JIGSAW_ENOMEM;
+		}
+		memcpy(js->wordarena + arenaused, word, i + 1);
+		wordofs[js->numword] = arenaused;
+		js->wlen[js->numword++] = i;
+		arenaused += i + 1;
+	}
+
+	memset(js->wordarena + arenaused, 0, WORDLENMAX);
+
+	// The arena stays put from here on, point into it
+	js->wordbase = (uint8_t **) malloc((js->numword + 1) * sizeof(*js->wordbase));
+	if (js->wordbase == NULL) {
+		free(wordofs);
+		return JIGSAW_ENOMEM;
+	}
+	for (w = 0; w < js->numword; w++)
+		js->wordbase[w] = js->wordarena + wordofs[w];
+	free(wordofs);
+	js->wordsetsize = ((js->numword + 63) / 64) * 8;
+
+	/*
+	 * Calculate links. These are indexes on the wordlist which are used
+	 * to quickly locate 1,2,3 long letter sequences within the words.
+	 */
+	js->numlinkdat = 0;
+	if (new_link(js) < 0) // 0 terminates chains
+		return JIGSAW_ENOMEM;
+	memset(js->links1, 0, sizeof(js->links1));
+	memset(js->links2, 0, sizeof(js->links2));
+	memset(js->links3, 0, sizeof(js->links3));
+	for (i = 0, done = 0; !done && i < WORDLENMAX; i++) {
+		done = 1;
+		for (w = js->numword - 1; w >= 0; w--) {
+			p = js->wordbase[w];
+			if (i >= 0 && i <= js->wlen[w] - 3) {
+				// With delimiters
+				if ((l = new_link(js)) < 0)
+					return JIGSAW_ENOMEM;
+				js->linkdat[l].w = w;
+				js->linkdat[l].ofs = -i;
+				js->linkdat[l].next = js->links3[p[i + 0]][p[i + 1]][p[i + 2]];
+				js->links3[p[i + 0]][p[i + 1]][p[i + 2]] = l;
+				done = 0;
+			}
+			if (i >= 0 && i <= js->wlen[w] - 2) {
+				// With delimiters
+				if ((l = new_link(js)) < 0)
+					return JIGSAW_ENOMEM;
+				js->linkdat[l].w = w;
+				js->linkdat[l].ofs = -i;
+				js->linkdat[l].next = js->links2[p[i + 0]][p[i + 1]];
+				js->links2[p[i + 0]][p[i + 1]] = l;
+				done = 0;
+			}
+			if (i > 0 && i <= js->wlen[w] - 2) {
+				// Without delimiters
+				if ((l = new_link(js)) < 0)
+					return JIGSAW_ENOMEM;
+				js->linkdat[l].w = w;
+				js->linkdat[l].ofs = -i;
+				js->linkdat[l].prev = p[i - 1];
+				js->linkdat[l].post = p[i + 1];
+				js->linkdat[l].next = js->links1[p[i]];
+				js->links1[p[i]] = l;
+				done = 0;
+			}
+		}
+	}
+
+	/*
+	 * Which characters can be placed on a free cell given the cells on
+	 * either side across the word. Stars always fit.
+	 */
+	for (x = 0; x < 32; x++) {
+		for (y = 0; y < 32; y++) {
+			js->fitmask[x][y] = 1u << STAR;
+			for (ch = 1; ch <= 'z' - BASE; ch++) {
+				if (ISCHAR(x) && ISCHAR(y))
+					l = js->links3[x][ch][y];
+				else if (ISCHAR(x))
+					l = js->links2[x][ch];
+				else if (ISCHAR(y))
+					l = js->links2[ch][y];
+				else
+					l = 1;
+				if (l)
+					js->fitmask[x][y] |= 1u << ch;
+			}
+		}
+	}
+
+	return JIGSAW_OK;
+}
+
+
+/*
+ * Public interface, see jigsaw.h
+ */
+
+const char *jigsaw_strerror(int error) {
+	switch (error) {
+	case JIGSAW_OK:
+		return "Done";
+	case JIGSAW_TIMEOUT:
+		return "Time is up";
+	case JIGSAW_STOPPED:
+		return "Stopped";
+	case JIGSAW_ENOMEM:
+		return "Out of memory";
+	case JIGSAW_EINVAL:
+		return "Invalid limits";
+	case JIGSAW_ELONG:
+		return "Word too long";
+	case JIGSAW_ETHREAD:
+		return "Cannot create thread";
+	case JIGSAW_EIO:
+		return "Cannot write checkpoint";
+	case JIGSAW_EFORMAT:
+		return "Invalid checkpoint";
+	default:
+		return "Unknown error";
+	}
+}
+
+const char *jigsaw_evalname(int eval) {
+	static const char *names[JIGSAW_EVALMAX] = { "conn", "word", "density", "compact", "adj" };
+
+	return eval >= 0 && eval < JIGSAW_EVALMAX ? names[eval] : NULL;
+}
+
+/*
+ * Release what a solve set up, the word list and node memory stay
+ */
+
+static void free_solve(struct jigsaw *js) {
+	int i;
+
+	free(js->xy2level);
+	free(js->level2xy);
+	free(js->xy2txy);
+	free(js->levelarea);
+	free(js->solution);
+	free(js->rootnode);
+	free(js->cmpnode[0]);
+	free(js->cmpnode[1]);
+	free(js->zobrist);
+	free(js->maxmore);
+	free(js->maxhalf);
+	free(js->resultgrid);
+	free(js->jobs);
+	js->xy2level = js->level2xy = js->xy2txy = NULL;
+	js->levelarea = NULL;
+	js->solution = js->rootnode = js->cmpnode[0] = js->cmpnode[1] = NULL;
+	js->zobrist = NULL;
+	js->maxmore = js->maxhalf = NULL;
+	js->resultgrid = NULL;
+	js->jobs = NULL;
+
+	for (i = 0; i < THREADMAX; i++) {
+		free(js->workers[i].scratch);
+		js->workers[i].scratch = NULL;
+	}
+}
+
+struct jigsaw *jigsaw_create(FILE *f, int *error) {
+	struct jigsaw *js;
+	int ret;
+
+	js = (struct jigsaw *) calloc(1, sizeof(struct jigsaw));
+	if (js == NULL) {
+		if (error)
+			*error = JIGSAW_ENOMEM;
+		return NULL;
+	}
+	pthread_mutex_init(&js->poolmutex, NULL);
+	pthread_cond_init(&js->batchcond, NULL);
+	pthread_cond_init(&js->donecond, NULL);
+
+	ret = jigsaw_load(js, f);
+	if (ret == JIGSAW_OK && grow_hash(js))
+		ret = JIGSAW_ENOMEM;
+	if (ret != JIGSAW_OK) {
+		jigsaw_destroy(js);
+		js = NULL;
+	}
+
+	if (error)
+		*error = ret;
+	return js;
+}
+
+int jigsaw_load(struct jigsaw *js, FILE *f) {
+	int ret;
+
+	// Only the word list is replaced, node memory stays warm
+	free(js->wordarena);
+	free(js->wordbase);
+	js->wordarena = NULL;
+	js->wordbase = NULL;
+	ret = load_words(js, f);
+	if (ret != JIGSAW_OK)
+		js->numword = 0;
+	return ret;
+}
+
+struct jigsaw *jigsaw_restore(FILE *f, struct jigsaw_limits *limits, int *error) {
+	struct jigsaw *js = NULL;
+	struct jigsaw_limits resume = *limits;
+	struct ckstream ckdata, *ck = &ckdata;
+	char magic[8], buf[4096], *data = NULL, *text = NULL;
+	size_t datasize = 0, textsize = 0, n;
+	uint64_t sum;
+	int i, len, numword, ret = JIGSAW_ENOMEM;
+	FILE *mem;
+
+	// Checkpoints are decoded in memory
+	mem = open_memstream(&data, &datasize);
+	if (mem == NULL)
+		goto done;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		fwrite(buf, 1, n, mem);
+	if (fclose(mem))
+		goto done;
+	ret = JIGSAW_EFORMAT;
+	if (ferror(f) || datasize < sizeof(sum))
+		goto done;
+	ck->f = NULL;
+	ck->p = (uint8_t *) data;
+	ck->end = ck->p + datasize - sizeof(sum);
+	ck->error = 0;
+	memcpy(&sum, ck->end, sizeof(sum));
+	if (ck_sum(CKSUMINIT, ck->p, ck->end - ck->p) != sum)
+		goto done;
+
+	// Options
+	if (get_bytes(ck, magic, sizeof(magic)) || memcmp(magic, CKMAGIC, sizeof(magic)))
+		goto done;
+	resume.width = get_uint(ck);
+	resume.height = get_uint(ck);
+	resume.nodemax = get_uint(ck);
+	resume.memmax = get_uint(ck);
+	resume.symmetrical = get_uint(ck);
+	resume.start = get_uint(ck);
+	resume.startmin = get_uint(ck);
+	get_bytes(ck, &resume.weight, sizeof(resume.weight));
+	get_bytes(ck, resume.eval, sizeof(resume.eval));
+
+	// Word list, in the text form jigsaw_load() takes
+	mem = open_memstream(&text, &textsize);
+	if (mem == NULL) {
+		ret = JIGSAW_ENOMEM;
+		goto done;
+	}
+	numword = get_uint(ck);
+	for (i = 0; i < numword && !ck->error; i++) {
+		len = get_uint(ck);
+		if (len < 1 || len > WORDLENMAX - 2 || ck->end - ck->p < len)
+			break;
+		fwrite(ck->p, 1, len, mem);
+		putc('\n', mem);
+		ck->p += len;
+	}
+	fclose(mem);
+	if (i < numword || numword == 0 || ck->error)
+		goto done;
+	mem = fmemopen(text, textsize, "r");
+	if (mem == NULL) {
+		ret = JIGSAW_ENOMEM;
+		goto done;
+	}
+	js = jigsaw_create(mem, &ret);
+	fclose(mem);
+	if (js == NULL)
+		goto done;
+	if (js->numword != numword) {
+		ret = JIGSAW_EFORMAT;
+		goto done;
+	}
+
+	// The frontier needs the grid, it waits for jigsaw_solve()
+	js->resumesize = ck->end - ck->p;
+	memmove(data, ck->p, js->resumesize);
+	js->resumedata = data;
+	data = NULL;
+	js->resume = resume;
+	*limits = resume;
+
+done:
+	free(data);
+	free(text);
+	if (ret != JIGSAW_OK && js) {
+		jigsaw_destroy(js);
+		js = NULL;
+	}
+	if (error)
+		*error = ret;
+	return js;
+}
+
+void jigsaw_limits_init(struct jigsaw_limits *limits) {
+	memset(limits, 0, sizeof(*limits));
+	limits->width = 20;
+	limits->height = 20;
+	limits->nodemax = 15000;			// 500=Fast 1500=Normal
+	limits->timemax = (10*60-15);			// 10 minute limit
+	limits->threads = 1;
+	limits->checkrounds = 5;
+	limits->eval[JIGSAW_EVAL_CONN] = 1;
+}
+
+/*
+ * Branch and bound, the most words room fits taking the shortest first. A
+ * word takes its length divided by div.
+ */
+
+static void fill_bound(struct jigsaw *js, int *maxmore, int room, int div) {
+	int lencnt[WORDLENMAX];
+	int i, w, x, y, used = 0;
+
+	memset(lencnt, 0, sizeof(lencnt));
+	for (w = 0; w < js->numword; w++)
+		lencnt[js->wlen[w] - 2]++;
+	for (i = 0, x = 0, y = 1; i <= room; i++) {
+		// x words with y the length of the next shortest
+		while (y < WORDLENMAX && (lencnt[y] == 0 || used + y / div <= i)) {
+			if (lencnt[y] == 0) {
+				y++;
+				continue;
+			}
+			lencnt[y]--;
+			used += y / div;
+			x++;
+		}
+		maxmore[i] = x;
+	}
+}
+
+int jigsaw_solve(struct jigsaw *js, const struct jigsaw_limits *limits,
+		 int (*callback)(struct jigsaw *js, void *arg), void *arg) {
+	struct node *d, *next;
+	int x, y, i, w, ret;
+	float evalsum = 0;
+
+	for (i = 0; i < JIGSAW_EVALMAX; i++) {
+		if (limits->eval[i] < 0)
+			return JIGSAW_EINVAL;
+		evalsum += limits->eval[i];
+	}
+	if (!(evalsum > 0))
+		return JIGSAW_EINVAL;
+
+	if (limits->width < 2 || limits->width > GRIDMAX || limits->height < 2 || limits->height > GRIDMAX ||
+	    limits->threads < 1 || limits->threads > THREADMAX || limits->memmax < 0 || limits->timemax < 0 || limits->timemaxms < 0 ||
+	    limits->start < 0 || limits->start > 1 || limits->startmin < 0 || limits->weight < 0 ||
+	    limits->checkrounds < 0 || limits->nodemax < 0)
+		return JIGSAW_EINVAL;
+
+	// Auto NODEMAX needs a time to fill
+	if (limits->nodemax == 0 && limits->timemax == 0 && limits->timemaxms == 0)
+		return JIGSAW_EINVAL;
+
+	// A checkpoint only continues on the grid it was made for
+	if (js->resumedata && (limits->width != js->resume.width || limits->height != js->resume.height ||
+	    limits->symmetrical != js->resume.symmetrical || limits->weight != js->resume.weight ||
+	    memcmp(limits->eval, js->resume.eval, sizeof(limits->eval))))
+		return JIGSAW_EINVAL;
+
+	js->opt_width = limits->width;
+	js->opt_height = limits->height;
+	js->opt_nodemax = limits->nodemax;
+	js->opt_timemax = limits->timemaxms ? limits->timemaxms * 1000000L : limits->timemax * 1000000000L;
+	js->opt_cputime = limits->cputime;
+	js->opt_memmax = limits->memmax;
+	js->opt_threads = limits->threads;
+	js->opt_symmetrical = limits->symmetrical;
+	js->opt_debug = limits->debug;
+	js->opt_dump = limits->dump;
+	js->opt_start = limits->start;
+	js->opt_startmin = limits->startmin;
+	js->opt_weight = limits->weight;
+	memcpy(js->opt_eval, limits->eval, sizeof(js->opt_eval));
+	js->opt_incumbent = limits->incumbent;
+	js->opt_telemetry = limits->telemetry;
+	js->opt_improve = limits->improve;
+	js->opt_checkpoint = limits->checkpoint;
+	js->opt_checkrounds = limits->checkrounds;
+	js->opt_terminate = limits->terminate;
+	js->incumbent = 0;
+	js->numround = 0;
+	js->totround = 0;
+	js->totscan = js->tothashtst = js->tothashhit = 0;
+	js->callback = callback;
+	js->arg = arg;
+	js->error = js->stop = 0;
+	js->seqnr = 0;
+
+	// Evaluators in play, connections only has its own path
+	js->numeval = 0;
+	if (limits->eval[JIGSAW_EVAL_CONN] != evalsum) {
+		for (i = 0; i < JIGSAW_EVALMAX; i++) {
+			if (limits->eval[i] > 0) {
+				js->evalidx[js->numeval] = i;
+				js->evalweight[js->numeval++] = limits->eval[i] / evalsum;
+			}
+		}
+	}
+	js->scorelo = 0;
+	js->scorescale = SCOREMAX - 1;
+
+	// start the timer
+	clock_gettime(CLOCK_MONOTONIC, &js->start);
+	for (i = 0; i < js->opt_threads; i++)
+		js->workers[i].cputime = 0;
+	js->workers[0].cpubase = thread_cpu();
+	js->autowidth = AUTOSTART;
+	js->nodemax = js->opt_nodemax ? js->opt_nodemax : js->autowidth;
+	js->timeout = 0;
+	js->lasttime = 0;
+	js->lastnode = 0;
+	pollcnt = POLLSTEP;
+
+	if (js->opt_debug) {
+		fprintf(stderr, "%s Loaded %d words\n", elapsedstr(js), js->numword);
+		fprintf(stderr, "%s Found %d links\n", elapsedstr(js), js->numlinkdat);
+	}
+
+	// Size the grid, nodes only carry the cells they need
+	free_solve(js);
+	js->gridxmax = js->opt_width + 2;
+	js->gridymax = js->opt_height + 2;
+	js->gridsize = js->gridxmax * js->gridymax;
+	js->nodesize = (sizeof(struct node) + 2 * js->gridsize + 7) & ~7;
+	js->markofs = (3 * js->gridsize + 7) & ~7;
+	js->wordsofs = js->markofs + 3 * js->gridsize * sizeof(struct adj);
+	js->fillofs = (js->wordsofs + js->wordsetsize + 1) & ~1;
+	js->scratchsize = sizeof(struct node) + js->fillofs + js->gridsize * sizeof(int16_t);
+	js->xy2level = (int16_t *) calloc(js->gridsize, sizeof(int16_t));
+	js->xy2txy = (int16_t *) calloc(js->gridsize, sizeof(int16_t));
+	js->level2xy = (int16_t *) calloc(js->gridxmax + js->gridymax + 1, sizeof(int16_t));
+	js->levelarea = (int *) calloc(js->gridxmax + js->gridymax + 1, sizeof(int));
+	js->solution = (struct node *) calloc(1, js->nodesize);
+	js->rootnode = (struct node *) calloc(1, js->scratchsize);
+	js->cmpnode[0] = (struct node *) malloc(js->scratchsize);
+	js->cmpnode[1] = (struct node *) malloc(js->scratchsize);
+	js->zobrist = (uint64_t *) malloc(js->gridsize * 32 * sizeof(uint64_t));
+	js->maxmore = (int *) calloc(3 * js->gridsize + 1, sizeof(int));
+	js->maxhalf = (int *) calloc(2 * js->gridsize + 1, sizeof(int));
+	js->resultgrid = (char *) malloc(js->opt_width * js->opt_height + 1);
+	if (js->xy2level == NULL || js->level2xy == NULL || js->xy2txy == NULL || js->levelarea == NULL || js->solution == NULL ||
+	    js->rootnode == NULL || js->cmpnode[0] == NULL || js->cmpnode[1] == NULL ||
+	    js->zobrist == NULL || js->maxmore == NULL || js->maxhalf == NULL || js->resultgrid == NULL) {
+		free_solve(js);
+		return JIGSAW_ENOMEM;
+	}
+
+	if (js->opt_debug)
+		fprintf(stderr, "sizeof(node)=%d\n", js->nodesize);
+
+	// init grid administration
+	for (i = 0; i < SCOREMAX; i++)
+		js->scoretail[i] = &js->scores[i];
+	init_zobrist(js);
+
+	// create an initial grid
+	d = js->rootnode;
+	for (y = js->gridymax - 1; y >= 0; y--) {
+		for (x = js->gridxmax - 1; x >= 0; x--) {
+			d->grid[x + y * js->gridxmax] = STAR;
+			ATTR(d)[x + y * js->gridxmax] = BORDER;
+		}
+	}
+	for (y = js->gridymax - 2; y > 0; y--) {
+		for (x = js->gridxmax - 2; x > 0; x--) {
+			d->grid[x + y * js->gridxmax] = FREE;
+			ATTR(d)[x + y * js->gridxmax] = 0;
+		}
+	}
+	for (y = js->gridymax - 1; y >= 0; y--) {
+		for (x = js->gridxmax - 1; x >= 0; x--) {
+			js->xy2txy[x + y * js->gridxmax] = y + x * js->gridymax;
+			TGRID(d)[y + x * js->gridymax] = d->grid[x + y * js->gridxmax];
+		}
+	}
+
+	d->numfree = js->opt_width * js->opt_height;
+
+	// Until a word is placed the solution is the empty grid
+	memcpy(js->solution, d, js->nodesize);
+
+	// Branch and bound, fill capacity with the shortest words first
+	fill_bound(js, js->maxmore, 3 * js->gridsize, 1);
+	fill_bound(js, js->maxhalf, 2 * js->gridsize, 2);
+
+	// Do some hotspot pre-calculations to fast skip empty grid areas
+	// with rectangular grids it's easier to track the start of scan diagonals instead of calfculating them
+	for (i = 0; i < js->gridsize; i++) {
+		int lvl = (i % js->gridxmax) + (i / js->gridxmax);
+		// xy -> level
+		js->xy2level[i] = lvl;
+		// level -> xy
+		if (!ISBORDER(ATTR(d)[i]) && !js->level2xy[lvl])
+			js->level2xy[lvl] = i;
+		// level -> # cells
+		if (!ISBORDER(ATTR(d)[i]))
+			js->levelarea[lvl]++;
+	}
+	for (i = 1; i <= js->gridxmax + js->gridymax; i++)
+		js->levelarea[i] += js->levelarea[i - 1];
+	js->area = js->opt_width * js->opt_height;
+
+	if (js->resumedata) {
+		// Continue from a checkpoint, it is used once
+		ret = read_checkpoint(js);
+		free(js->resumedata);
+		js->resumedata = NULL;
+		if (ret != JIGSAW_OK)
+			return ret;
+	} else {
+		// Place all the words for starters
+		for (w = js->numword - 1; w >= 0; w--) {
+			if (js->wlen[w] - 2 < js->opt_startmin)
+				continue;
+			if (js->opt_symmetrical) {
+				// work from the middle out
+				if (js->wlen[w] < 5)
+					continue;
+				d->hash = 0;
+				if (js->gridymax & 1) {
+					// Odd height, centred on the middle row the word is its own mirror image
+					if ((js->gridxmax - js->wlen[w]) & 1)
+						continue;
+					place_hword(js, d, (js->gridxmax - js->wlen[w]) / 2 + (js->gridymax / 2) * js->gridxmax, w);
+				} else {
+					// Even height, the mirror image is on the row above
+					place_hword(js, d, (js->gridxmax / 2 + 2 - js->wlen[w]) + (js->gridymax / 2) * js->gridxmax, w);
+				}
+			} else if (js->opt_start == 1) {
+				// work from the middle, sweeping the whole grid
+				place_hword(js, d, (js->gridxmax / 2 + 2 - js->wlen[w]) + (js->gridymax / 2) * js->gridxmax, w);
+			} else {
+				// work from top-left to bottom-right
+				d->firstlevel = 2;
+				place_hword(js, d, 0 + 1 * js->gridxmax, w);
+			}
+		}
+	}
+
+	// Here we go
+	ret = kick_ass(js);
+
+	// Spend the time left on the solution
+	if (ret == JIGSAW_OK && js->opt_improve)
+		ret = improve(js);
+
+	// Unless the solve failed before it could continue the checkpoint
+	for (d = js->resumetodo; d; d = next) {
+		next = d->next;
+		release_node(js, d);
+	}
+	js->resumetodo = NULL;
+	js->resumed = 0;
+
+	// Grids left after a timeout go back to the free lists
+	for (i = 0; i < SCOREMAX; i++) {
+		for (d = js->scores[i]; d; d = next) {
+			next = d->next;
+			release_node(js, d);
+		}
+		js->scores[i] = NULL;
+	}
+
+	return ret;
+}
+
+void jigsaw_result(struct jigsaw *js, struct jigsaw_result *result) {
+	char *p;
+	int x, y;
+
+	memset(result, 0, sizeof(*result));
+	result->grid = "";
+	if (js->solution == NULL)
+		return;
+
+	result->numword = js->solution->numword;
+	result->score = js->solution->score;
+	result->elapsed = elapsed(js);
+	result->width = js->opt_width;
+	result->height = js->opt_height;
+	result->rounds = js->totround;
+	result->nodes = js->totscan;
+	result->hashtst = js->tothashtst;
+	result->hashhit = js->tothashhit;
+	for (p = js->resultgrid, y = 1; y < js->gridymax - 1; y++)
+		for (x = 1; x < js->gridxmax - 1; x++)
+			if (ISCHAR(js->solution->grid[x + y * js->gridxmax]))
+				*p++ = js->solution->grid[x + y * js->gridxmax] + BASE;
+			else
+				*p++ = '-';
+	*p = 0;
+	result->grid = js->resultgrid;
+}
+
+void jigsaw_print(struct jigsaw *js, FILE *f) {
+	if (js->solution)
+		dump_grid(js, js->solution, f);
+}
+
+void jigsaw_destroy(struct jigsaw *js) {
+	int i;
+
+	free_solve(js);
+	for (i = 0; i < js->numslab; i++)
+		free(js->slabs[i]);
+	free(js->slabs);
+	free(js->hashtab);
+	free(js->wordarena);
+	free(js->wordbase);
+	free(js->wlen);
+	free(js->linkdat);
+	free(js->cknodes);
+	free(js->resumedata);
+	pthread_mutex_destroy(&js->poolmutex);
+	pthread_cond_destroy(&js->batchcond);
+	pthread_cond_destroy(&js->donecond);
+	free(js);
+}